@@ -0,0 +1,276 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include "Blur.h"
+#include "Resize.h"
+#include "HistEq.h"
+#include "Normalize.h"
+#include "Color.h"
+#include "EdgeDetection.h"
+#include "EdgeProcessing.h"
+
+// Microbenchmark for the hand-written vision:: kernels against their cv:: equivalents.
+// Sweeps the frame sizes the pipeline actually sees and reports ns/pixel for both
+// implementations plus an output equivalence check (max abs diff and % of pixels
+// outside the kernel's tolerance).
+//
+// Usage: kernel_bench [image]   (defaults to sample/sample2.jpg, synthetic eye if missing)
+
+namespace {
+    struct BenchCase {
+        std::string name;
+        cv::Size size;
+    };
+
+    struct Equivalence {
+        bool checked = false;
+        double maxDiff = 0.0;
+        double mismatchPct = 0.0;
+        bool pass = true;
+    };
+
+    // Median wall time of one call, in nanoseconds. Runs at least minReps and
+    // keeps going until ~minTotalMs has elapsed so tiny kernels get enough samples.
+    double timeNs(const std::function<void()>& fn, int minReps = 5, double minTotalMs = 150.0) {
+        using clock = std::chrono::steady_clock;
+        fn(); // warm-up (allocations, OpenMP pool)
+        std::vector<double> samples;
+        auto begin = clock::now();
+        while ((int)samples.size() < minReps ||
+            std::chrono::duration<double, std::milli>(clock::now() - begin).count() < minTotalMs) {
+            auto t0 = clock::now();
+            fn();
+            auto t1 = clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+            if (samples.size() >= 2000) break;
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    Equivalence compare(const cv::Mat& ours, const cv::Mat& ref, double tolerance, double maxMismatchPct = 0.5) {
+        Equivalence eq;
+        eq.checked = true;
+        if (ours.size() != ref.size() || ours.channels() != ref.channels()) {
+            eq.pass = false;
+            eq.maxDiff = -1;
+            eq.mismatchPct = 100.0;
+            return eq;
+        }
+        cv::Mat a, b;
+        ours.convertTo(a, CV_64F);
+        ref.convertTo(b, CV_64F);
+        cv::Mat diff;
+        cv::absdiff(a, b, diff);
+        cv::minMaxLoc(diff.reshape(1), nullptr, &eq.maxDiff);
+        cv::Mat bad = diff.reshape(1) > tolerance;
+        eq.mismatchPct = 100.0 * cv::countNonZero(bad) / (double)bad.total();
+        // Allow a sliver of outliers (border conventions, rounding ties); rows
+        // that must be exact pass maxMismatchPct = 0
+        eq.pass = eq.mismatchPct <= maxMismatchPct;
+        return eq;
+    }
+
+    cv::Mat makeSyntheticEye(cv::Size size) {
+        cv::Mat img(size, CV_8UC3);
+        cv::randu(img, cv::Scalar(120, 120, 120), cv::Scalar(180, 180, 180));
+        cv::GaussianBlur(img, img, cv::Size(0, 0), 2.0);
+        cv::Point c(size.width / 2, size.height / 2);
+        int r = std::max(4, size.height / 8);
+        cv::ellipse(img, c, cv::Size(r * 2, r), 0, 0, 360, cv::Scalar(200, 190, 185), -1);
+        cv::circle(img, c, r, cv::Scalar(30, 30, 30), -1);
+        cv::circle(img, c + cv::Point(r / 3, -r / 3), std::max(1, r / 6), cv::Scalar(250, 250, 250), -1);
+        return img;
+    }
+
+    void printRow(const std::string& size, const std::string& kernel, double pixels,
+        double oursNs, double refNs, const Equivalence& eq) {
+        std::cout << std::left << std::setw(12) << size
+            << std::setw(20) << kernel
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << oursNs / pixels;
+        if (refNs > 0) {
+            std::cout << std::setw(12) << refNs / pixels
+                << std::setw(10) << refNs / oursNs << "x";
+        }
+        else {
+            std::cout << std::setw(12) << "-" << std::setw(11) << "-";
+        }
+        if (eq.checked) {
+            std::cout << std::setw(10) << std::setprecision(1) << eq.maxDiff
+                << std::setw(10) << std::setprecision(3) << eq.mismatchPct << "%"
+                << (eq.pass ? "  PASS" : "  FAIL");
+        }
+        else {
+            std::cout << std::setw(10) << "-" << std::setw(11) << "-" << "  n/a";
+        }
+        std::cout << std::endl;
+    }
+}
+
+//Change to main()
+int kernel_benchmark(int argc, char** argv) {
+    std::string imagePath = (argc > 1) ? argv[1] : "sample/sample2.jpg";
+    cv::Mat source = cv::imread(imagePath);
+    if (source.empty())
+        std::cout << "Could not load " << imagePath << ", using a synthetic eye image" << std::endl;
+
+    const std::vector<BenchCase> cases = {
+        { "192x192", cv::Size(192, 192) },   // PuRe working area
+        { "320x240", cv::Size(320, 240) },
+        { "432x324", cv::Size(432, 324) },   // kDefaultHeight ROI
+        { "640x480", cv::Size(640, 480) },   // camera frame
+        { "1920x1080", cv::Size(1920, 1080) },
+    };
+
+    const double sigma = 1.5;
+
+    std::cout << std::left << std::setw(12) << "size" << std::setw(20) << "kernel"
+        << std::right << std::setw(12) << "ns/px" << std::setw(12) << "cv ns/px"
+        << std::setw(11) << "speedup" << std::setw(10) << "maxdiff" << std::setw(11) << "mismatch"
+        << std::endl;
+
+    for (const auto& bc : cases) {
+        cv::Mat bgr;
+        if (source.empty()) bgr = makeSyntheticEye(bc.size);
+        else cv::resize(source, bgr, bc.size, 0, 0, cv::INTER_AREA);
+        cv::Mat gray;
+        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        const double px = (double)bc.size.area();
+
+        cv::Mat ours, ref;
+        double tOurs, tRef;
+
+        // Gaussian blur (replicate border, kernel radius ceil(3 sigma) on both sides)
+        {
+            int radius = std::max(1, (int)std::ceil(3.0 * sigma));
+            cv::Size k(2 * radius + 1, 2 * radius + 1);
+            tOurs = timeNs([&] { vision::blur::GaussianBlur(gray, ours, sigma, radius, cv::BORDER_REPLICATE); });
+            tRef = timeNs([&] { cv::GaussianBlur(gray, ref, k, sigma, sigma, cv::BORDER_REPLICATE); });
+            printRow(bc.name, "GaussianBlur", px, tOurs, tRef, compare(ours, ref, 1.0));
+        }
+
+        // Recursive Gaussian blur (IIR approximation, looser tolerance)
+        {
+            int radius = std::max(1, (int)std::ceil(3.0 * sigma));
+            cv::Size k(2 * radius + 1, 2 * radius + 1);
+            tOurs = timeNs([&] { vision::blur::RecursiveGaussianBlur(gray, ours, sigma, cv::BORDER_REPLICATE); });
+            tRef = timeNs([&] { cv::GaussianBlur(gray, ref, k, sigma, sigma, cv::BORDER_REPLICATE); });
+            printRow(bc.name, "RecursiveGaussian", px, tOurs, tRef, compare(ours, ref, 3.0));
+        }
+
+        // FFT Gaussian blur (reflect padding)
+        {
+            int radius = std::max(1, (int)std::ceil(3.0 * sigma));
+            cv::Size k(2 * radius + 1, 2 * radius + 1);
+            tOurs = timeNs([&] { ours = vision::blur::FFTGaussianBlur(gray, sigma); });
+            tRef = timeNs([&] { cv::GaussianBlur(gray, ref, k, sigma, sigma, cv::BORDER_REFLECT); });
+            printRow(bc.name, "FFTGaussianBlur", px, tOurs, tRef, compare(ours, ref, 1.0));
+        }
+
+        // Resize to half size (downscale is what the pipeline does)
+        {
+            cv::Size half(bc.size.width / 2, bc.size.height / 2);
+            tOurs = timeNs([&] { vision::resize::resize(gray, ours, half, 0, 0, vision::resize::INTER_LINEAR); });
+            tRef = timeNs([&] { cv::resize(gray, ref, half, 0, 0, cv::INTER_LINEAR); });
+            printRow(bc.name, "resize LINEAR", px, tOurs, tRef, compare(ours, ref, 1.0));
+
+            tOurs = timeNs([&] { vision::resize::resize(gray, ours, half, 0, 0, vision::resize::INTER_AREA); });
+            tRef = timeNs([&] { cv::resize(gray, ref, half, 0, 0, cv::INTER_AREA); });
+            printRow(bc.name, "resize AREA", px, tOurs, tRef, compare(ours, ref, 1.0));
+
+            tOurs = timeNs([&] { vision::resize::resize(gray, ours, half, 0, 0, vision::resize::INTER_CUBIC); });
+            tRef = timeNs([&] { cv::resize(gray, ref, half, 0, 0, cv::INTER_CUBIC); });
+            printRow(bc.name, "resize CUBIC", px, tOurs, tRef, compare(ours, ref, 2.0));
+        }
+
+        // CLAHE with the pipeline's parameters
+        {
+            cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(6, 6));
+            tOurs = timeNs([&] { vision::histeq::CLAHE(gray, ours, 2.0, cv::Size(6, 6)); });
+            tRef = timeNs([&] { clahe->apply(gray, ref); });
+            printRow(bc.name, "CLAHE", px, tOurs, tRef, compare(ours, ref, 2.0));
+        }
+
+        // Min-max normalize to 8 bit (what PuRe::run does)
+        {
+            tOurs = timeNs([&] { vision::normalize::normalize(gray, ours, 0, 255, vision::normalize::NORM_MINMAX); });
+            tRef = timeNs([&] { cv::normalize(gray, ref, 0, 255, cv::NORM_MINMAX, CV_8U); });
+            printRow(bc.name, "normalize MINMAX", px, tOurs, tRef, compare(ours, ref, 1.0));
+        }
+
+        // BGR -> gray
+        {
+            tOurs = timeNs([&] { vision::color::BGR2Gray(bgr, ours); });
+            tRef = timeNs([&] { cv::cvtColor(bgr, ref, cv::COLOR_BGR2GRAY); });
+            printRow(bc.name, "BGR2Gray", px, tOurs, tRef, compare(ours, ref, 1.0));
+
+            cv::Size half(bc.size.width / 2, bc.size.height / 2);
+            tOurs = timeNs([&] { vision::color::BGR2GrayDecimate(bgr, ours, 2); });
+            tRef = timeNs([&] {
+                cv::Mat g;
+                cv::cvtColor(bgr, g, cv::COLOR_BGR2GRAY);
+                cv::resize(g, ref, half, 0, 0, cv::INTER_AREA);
+            });
+            printRow(bc.name, "BGR2Gray /2", px, tOurs, tRef, compare(ours, ref, 1.0));
+        }
+
+        // Canny: thresholds are chosen adaptively from the magnitude histogram,
+        // so cv::Canny is only a speed reference, not an equivalence target
+        cv::Mat edges;
+        {
+            tOurs = timeNs([&] { edges = vision::canny::canny(gray, true); });
+            tRef = timeNs([&] { cv::Canny(gray, ref, 50, 125); });
+            printRow(bc.name, "canny", px, tOurs, tRef, Equivalence());
+
+            vision::canny::CannyEngine engine;
+            engine.setGradientMode(vision::canny::GradientMode::Integer7);
+            tOurs = timeNs([&] { engine.detect(gray, true); });
+            printRow(bc.name, "canny Integer7", px, tOurs, tRef, Equivalence());
+
+            engine.setGradientMode(vision::canny::GradientMode::DerivativeOfGaussian);
+            tOurs = timeNs([&] { engine.detect(gray, true); });
+            printRow(bc.name, "canny DoG", px, tOurs, tRef, Equivalence());
+        }
+
+        // Edge filtering has no OpenCV counterpart
+        {
+            cv::Mat filtered;
+            tOurs = timeNs([&] { vision::edge::filterEdges(edges, filtered); });
+            printRow(bc.name, "filterEdges", px, tOurs, -1.0, Equivalence());
+
+            vision::edge::EdgeFilter filter;
+            tOurs = timeNs([&] { edges.copyTo(filtered); filter.apply(filtered); });
+            printRow(bc.name, "EdgeFilter packed", px, tOurs, -1.0, Equivalence());
+
+            // Sparse path, fed the pixel list hysteresis collects
+            vision::canny::CannyEngine lister;
+            lister.setCollectPixels(true);
+            cv::Mat listed = lister.detect(gray, true).clone();
+            std::vector<int> pixels;
+            cv::Mat sparse;
+            tRef = tOurs;
+            tOurs = timeNs([&] { listed.copyTo(sparse); pixels = lister.pixels(); filter.apply(sparse, pixels); });
+            printRow(bc.name, "EdgeFilter sparse", px, tOurs, tRef, compare(sparse, filtered, 0.0, 0.0));
+
+            // Segment extraction; findContours traces open curves on both sides,
+            // so only the timings compare
+            vision::edge::EdgeLinker linker;
+            tOurs = timeNs([&] { linker.link(filtered, pixels, vision::edge::LinkPoints::Anchors); });
+            tRef = timeNs([&] {
+                std::vector<std::vector<cv::Point> > curves;
+                cv::findContours(filtered, curves, cv::RETR_LIST, cv::CHAIN_APPROX_TC89_KCOS);
+            });
+            printRow(bc.name, "EdgeLinker", px, tOurs, tRef, Equivalence());
+        }
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
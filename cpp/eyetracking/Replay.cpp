@@ -0,0 +1,263 @@
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <filesystem> // C++17
+#include "PupilDetector.h"
+#include "Profiler.h"
+#include "Capture.h"
+
+using namespace vision::detection;
+namespace fs = std::filesystem;
+
+// Headless replay benchmark: feeds recorded frames through PupilDetector as fast
+// as possible and reports throughput, latency percentiles and detection rate.
+//
+// Usage: replay <image folder | video file> [output.csv] [--haar] [--warmup N] [--repeat N]
+//               [--profile stages.json] [--yuv WxH[:i420|nv12|yuyv|uyvy]]
+//
+// With --yuv the source is a headerless raw YUV file; only its Y plane is read and
+// the detector gets single-channel frames (the luma capture path).
+//
+// Image folders are read in natural order ("2-eye.png" before "10-eye.png"), so
+// the frame dumps used by Testing.cpp can be replayed directly.
+
+namespace {
+    struct FrameRecord {
+        int index;
+        bool detected;
+        Pupil pupil;
+        double latencyMs;
+    };
+
+    bool isImageFile(const fs::path& p) {
+        std::string ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff";
+    }
+
+    // Compare file names by embedded numbers so 2-eye.png sorts before 10-eye.png
+    bool naturalLess(const std::string& a, const std::string& b) {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (isdigit((unsigned char)a[i]) && isdigit((unsigned char)b[j])) {
+                size_t ei = i, ej = j;
+                while (ei < a.size() && isdigit((unsigned char)a[ei])) ++ei;
+                while (ej < b.size() && isdigit((unsigned char)b[ej])) ++ej;
+                unsigned long long na = std::stoull(a.substr(i, ei - i));
+                unsigned long long nb = std::stoull(b.substr(j, ej - j));
+                if (na != nb) return na < nb;
+                i = ei; j = ej;
+            }
+            else {
+                if (a[i] != b[j]) return a[i] < b[j];
+                ++i; ++j;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+
+    // Loads every frame up front so disk/decode time is not part of the measurement
+    bool loadFrames(const std::string& source, std::vector<cv::Mat>& frames) {
+        if (fs::is_directory(source)) {
+            std::vector<fs::path> files;
+            for (const auto& entry : fs::directory_iterator(source)) {
+                if (entry.is_regular_file() && isImageFile(entry.path()))
+                    files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end(), [](const fs::path& a, const fs::path& b) {
+                return naturalLess(a.filename().string(), b.filename().string());
+            });
+            for (const auto& f : files) {
+                cv::Mat img = cv::imread(f.string());
+                if (img.empty()) {
+                    std::cerr << "Warning: Could not load " << f.string() << std::endl;
+                    continue;
+                }
+                frames.push_back(img);
+            }
+        }
+        else {
+            cv::VideoCapture cap(source);
+            if (!cap.isOpened()) return false;
+            cv::Mat frame;
+            while (cap.read(frame)) {
+                if (frame.empty()) break;
+                frames.push_back(frame.clone());
+            }
+        }
+        return !frames.empty();
+    }
+
+    // Parses "640x480" or "640x480:nv12"
+    bool parseYuvSpec(const std::string& spec, cv::Size& size, vision::capture::YuvLayout& layout) {
+        size_t x = spec.find('x');
+        if (x == std::string::npos) return false;
+        size_t colon = spec.find(':', x);
+        int w = std::atoi(spec.substr(0, x).c_str());
+        int h = std::atoi(spec.substr(x + 1, colon == std::string::npos ? std::string::npos : colon - x - 1).c_str());
+        if (w <= 0 || h <= 0) return false;
+        size = cv::Size(w, h);
+        layout = colon == std::string::npos ? vision::capture::YuvLayout::I420
+            : vision::capture::parseLayout(spec.substr(colon + 1));
+        return layout != vision::capture::YuvLayout::Auto;
+    }
+
+    bool loadYuvFrames(const std::string& source, cv::Size size, vision::capture::YuvLayout layout, std::vector<cv::Mat>& frames) {
+        vision::capture::LumaCapture cap;
+        if (!cap.openRawFile(source, size, layout)) return false;
+        cv::Mat luma;
+        while (cap.read(luma))
+            frames.push_back(luma.clone());
+        return !frames.empty();
+    }
+
+    double percentile(std::vector<double> sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        double rank = p / 100.0 * (sorted.size() - 1);
+        size_t lo = (size_t)rank;
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        double t = rank - lo;
+        return sorted[lo] * (1.0 - t) + sorted[hi] * t;
+    }
+}
+
+//Change to main()
+int replay_benchmark(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+            << " <image folder | video file> [output.csv] [--haar] [--warmup N] [--repeat N]"
+            << " [--profile stages.json] [--yuv WxH[:i420|nv12|yuyv|uyvy]]" << std::endl;
+        return -1;
+    }
+
+    std::string source = argv[1];
+    std::string csvPath = "replay.csv";
+    bool useHaar = false;
+    int warmup = 10;
+    int repeat = 1;
+    std::string profilePath;
+    std::string yuvSpec;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--haar") useHaar = true;
+        else if (arg == "--warmup" && i + 1 < argc) warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--profile" && i + 1 < argc) profilePath = argv[++i];
+        else if (arg == "--yuv" && i + 1 < argc) yuvSpec = argv[++i];
+        else csvPath = arg;
+    }
+
+    std::vector<cv::Mat> frames;
+    bool loaded = false;
+    if (!yuvSpec.empty()) {
+        cv::Size yuvSize;
+        vision::capture::YuvLayout layout;
+        if (!parseYuvSpec(yuvSpec, yuvSize, layout)) {
+            std::cerr << "Bad --yuv spec " << yuvSpec << " (expected WxH[:i420|nv12|yuyv|uyvy])" << std::endl;
+            return -1;
+        }
+        loaded = loadYuvFrames(source, yuvSize, layout, frames);
+    }
+    else {
+        loaded = loadFrames(source, frames);
+    }
+    if (!loaded) {
+        std::cerr << "Cannot read frames from " << source << std::endl;
+        return -1;
+    }
+    std::cout << "Loaded " << frames.size() << " frames from " << source << std::endl;
+
+    std::string faceCascadePath = "haarcascade_frontalface_default.xml";
+    std::string eyeCascadePath = "haarcascade_eye.xml";
+
+    // Warm-up on a separate detector so caches/allocations settle without
+    // leaking tracking state into the measured run
+    {
+        PupilDetector warm(faceCascadePath, eyeCascadePath);
+        for (int i = 0; i < warmup; ++i)
+            warm.processFrame(frames[i % frames.size()], useHaar);
+    }
+    vision::profile::Profiler::instance().reset();
+
+    std::vector<FrameRecord> records;
+    records.reserve(frames.size() * repeat);
+
+    using clock = std::chrono::steady_clock;
+    auto runStart = clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        PupilDetector detector(faceCascadePath, eyeCascadePath);
+        for (size_t i = 0; i < frames.size(); ++i) {
+            auto t0 = clock::now();
+            Pupil pupil = detector.processFrame(frames[i], useHaar);
+            auto t1 = clock::now();
+
+            FrameRecord rec;
+            rec.index = (int)i;
+            rec.detected = pupil.hasOutline();
+            rec.pupil = pupil;
+            rec.latencyMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            records.push_back(rec);
+        }
+    }
+    double totalSec = std::chrono::duration<double>(clock::now() - runStart).count();
+
+    std::vector<double> latencies;
+    latencies.reserve(records.size());
+    int detectedCount = 0;
+    for (const auto& rec : records) {
+        latencies.push_back(rec.latencyMs);
+        if (rec.detected) detectedCount++;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double meanMs = 0.0;
+    for (double l : latencies) meanMs += l;
+    meanMs /= latencies.size();
+
+    std::cout << "Frames processed : " << records.size() << std::endl;
+    std::cout << "Throughput       : " << records.size() / totalSec << " fps" << std::endl;
+    std::cout << "Latency mean     : " << meanMs << " ms" << std::endl;
+    std::cout << "Latency p50      : " << percentile(latencies, 50.0) << " ms" << std::endl;
+    std::cout << "Latency p95      : " << percentile(latencies, 95.0) << " ms" << std::endl;
+    std::cout << "Latency p99      : " << percentile(latencies, 99.0) << " ms" << std::endl;
+    std::cout << "Latency max      : " << latencies.back() << " ms" << std::endl;
+    std::cout << "Detection rate   : " << 100.0 * detectedCount / records.size() << " %" << std::endl;
+
+    // Per-frame pupils from the first pass (repeats only add timing samples)
+    std::ofstream csv(csvPath);
+    if (!csv.is_open()) {
+        std::cerr << "Cannot write " << csvPath << std::endl;
+        return -1;
+    }
+    csv << "frame,detected,center_x,center_y,width,height,angle,confidence,latency_ms\n";
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameRecord& rec = records[i];
+        csv << rec.index << ","
+            << (rec.detected ? 1 : 0) << ","
+            << rec.pupil.center.x << ","
+            << rec.pupil.center.y << ","
+            << rec.pupil.size.width << ","
+            << rec.pupil.size.height << ","
+            << rec.pupil.angle << ","
+            << rec.pupil.confidence << ","
+            << rec.latencyMs << "\n";
+    }
+    std::cout << "Per-frame pupils written to " << csvPath << std::endl;
+
+    // Stage histograms are only populated when built with VISION_ENABLE_PROFILING
+    if (!profilePath.empty()) {
+        if (!vision::profile::kEnabled)
+            std::cerr << "Warning: built without VISION_ENABLE_PROFILING, stage timings are empty" << std::endl;
+        if (vision::profile::Profiler::instance().writeJson(profilePath))
+            std::cout << "Stage timings written to " << profilePath << std::endl;
+        else
+            std::cerr << "Cannot write " << profilePath << std::endl;
+    }
+
+    return 0;
+}
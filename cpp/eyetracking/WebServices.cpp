@@ -11,6 +11,7 @@
 #include "callibrate.h"
 #include "tracking.h"
 #include "PupilDetector.h"
+#include "Capture.h"
 
 using namespace vision::detection;
 using namespace vision::calibration;
@@ -25,6 +26,7 @@ std::atomic<bool> calibrationActive{ false };
 std::atomic<bool> useHaar{ true };
 std::atomic<bool> calibrationRunning{ false }; // Prevent camera conflicts during calibration
 std::atomic<int> rotateDegree{ 0 };
+std::atomic<bool> lumaCapture{ false }; // Read the Y plane instead of decoding to BGR
 std::mutex frameMutex;
 std::mutex modelMutex;
 std::mutex cameraMutex; // Protect camera access
@@ -92,6 +94,8 @@ int main() { //Change to main()
     // Start background camera thread
     std::thread([&detector]() {
         cv::VideoCapture cap;
+        vision::capture::LumaCapture lumaCap;
+        bool luma = false;
         bool cameraOpened = false;
         int consecutiveErrors = 0;
         const int maxErrors = 10;
@@ -101,6 +105,7 @@ int main() { //Change to main()
             if (!backendActive.load()) {
                 if (cameraOpened) {
                     cap.release();
+                    lumaCap.release();
                     cameraOpened = false;
                 }
                 std::this_thread::sleep_for(100ms);
@@ -111,6 +116,7 @@ int main() { //Change to main()
             if (calibrationRunning.load()) {
                 if (cameraOpened) {
                     cap.release();
+                    lumaCap.release();
                     cameraOpened = false;
                 }
                 std::this_thread::sleep_for(100ms);
@@ -120,16 +126,25 @@ int main() { //Change to main()
             // Open camera if not opened
             if (!cameraOpened) {
                 std::lock_guard<std::mutex> lock(cameraMutex);
-                if (currentCamera.type == CAM_LINK)
-                    cap.open(currentCamera.link);
-                else if (currentCamera.type == CAM_INT)
-                    cap.open(currentCamera.camIndex);
+                luma = lumaCapture.load();
+                if (currentCamera.type == CAM_LINK) {
+                    if (luma) lumaCap.open(currentCamera.link);
+                    else cap.open(currentCamera.link);
+                }
+                else if (currentCamera.type == CAM_INT) {
+                    if (luma) lumaCap.open(currentCamera.camIndex, 640, 480);
+                    else cap.open(currentCamera.camIndex);
+                }
                 else {
                     std::cerr << "Please set the camera first using /camera/link or /camera/cam\n";
                     std::this_thread::sleep_for(1000ms);
                     continue;
                 }
-                if (cap.isOpened()) {
+                if (luma && lumaCap.isOpened()) {
+                    cameraOpened = true;
+                    consecutiveErrors = 0;
+                    std::cout << "Camera opened (luma" << (lumaCap.isRaw() ? "" : ", BGR fallback") << ")\n";
+                } else if (!luma && cap.isOpened()) {
                     cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
                     cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
                     cameraOpened = true;
@@ -146,7 +161,7 @@ int main() { //Change to main()
             bool grabbed = false;
             {
                 std::lock_guard<std::mutex> lock(cameraMutex);
-                grabbed = cap.grab();
+                grabbed = luma ? lumaCap.grab() : cap.grab();
             }
             
             if (!grabbed) {
@@ -154,6 +169,7 @@ int main() { //Change to main()
                 if (consecutiveErrors >= maxErrors) {
                     std::cerr << "Too many camera errors, releasing camera\n";
                     cap.release();
+                    lumaCap.release();
                     cameraOpened = false;
                     consecutiveErrors = 0;
                     std::this_thread::sleep_for(500ms);
@@ -165,7 +181,8 @@ int main() { //Change to main()
             
             {
                 std::lock_guard<std::mutex> lock(cameraMutex);
-                cap.retrieve(frame);
+                if (luma) lumaCap.retrieve(frame);
+                else cap.retrieve(frame);
             }
             
             if (frame.empty()) continue;
@@ -302,6 +319,24 @@ int main() { //Change to main()
         res->end("Camera set to index: " + std::to_string(camIndex));
         });
 
+    // HTTP: switch between BGR and luma (Y plane) capture
+    app.get("/camera/luma", [setCORS](auto* res, auto* req) {
+        setCORS(res);
+        if (backendActive.load()) {
+            res->end("Please turn off backend first");
+            return;
+        }
+
+        std::string_view on = req->getQuery("on");
+        if (on.empty()) {
+            res->end("Missing ?on parameter");
+            return;
+        }
+
+        lumaCapture.store(on == "1" || on == "true");
+        res->end(lumaCapture.load() ? "Luma capture enabled" : "Luma capture disabled");
+        });
+
     // HTTP: set rotation degree
     app.get("/rotate", [setCORS](auto* res, auto* req) {
         setCORS(res);
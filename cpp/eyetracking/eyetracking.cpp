@@ -4,6 +4,7 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <vector>
+#include <mutex>
 #include "callibrate.h"
 #include "tracking.h"
 #include "PupilDetector.h"
@@ -15,7 +16,16 @@ int main() {
     std::string faceCascadePath = "haarcascade_frontalface_default.xml";
     std::string eyeCascadePath = "haarcascade_eye.xml";
 
+    // PuRe debug view: rendered off the detection thread, shown from this loop.
+    // Declared before the detector so they outlive its sink worker.
+    std::mutex debugMutex;
+    cv::Mat debugView;
+
     PupilDetector detector(faceCascadePath, eyeCascadePath);
+    detector.setDebugSink([&](const std::string&, const cv::Mat& image) {
+        std::lock_guard<std::mutex> lock(debugMutex);
+        debugView = image;
+    });
 
     //3 : OBS
 	//0 : Kamera laptop
@@ -48,6 +58,10 @@ int main() {
             ellipse(view, wp, cv::Scalar(0, 0, 255));
         }
         imshow("Results", view);
+        {
+            std::lock_guard<std::mutex> lock(debugMutex);
+            if (!debugView.empty()) imshow("selected", debugView);
+        }
 
         //cv::ellipse(frame, cv::Point(result.center), cv::Size(result.axes), result.angle, 0, 360, cv::Scalar(0, 0, 255));
 
@@ -3,8 +3,21 @@
 
 namespace vision {
 	namespace blur {
+		// Gaussian blur methods
+		constexpr int GAUSSIAN_DIRECT = 0;     // separable convolution, cost grows with sigma
+		constexpr int GAUSSIAN_FFT = 1;        // FFT convolution, for large sigmas
+		constexpr int GAUSSIAN_RECURSIVE = 2;  // IIR (Young-van Vliet), cost independent of sigma
+
 		void GaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int radius = 0, int borderType = cv::BORDER_REPLICATE);
 		cv::Mat GaussianBlur(const cv::Mat& src, double sigma, int radius = 0, int borderType = cv::BORDER_REPLICATE);
-		cv::Mat FFTGaussianBlur(const cv::Mat& src, double sigma);
+		void GaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int radius, int borderType, int method);
+		// Same kernel as GaussianBlur (radius ceil(3 sigma)), computed with the real FFT.
+		// Cost grows with log(size + sigma) only, so it wins for large sigmas.
+		cv::Mat FFTGaussianBlur(const cv::Mat& src, double sigma, int borderType = cv::BORDER_REFLECT);
+
+		// Recursive Gaussian (sigma >= 0.5). Supports the same border types as GaussianBlur;
+		// BORDER_REPLICATE is handled exactly, the reflect/wrap modes extend each line by ~4 sigma.
+		void RecursiveGaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int borderType = cv::BORDER_REPLICATE);
+		cv::Mat RecursiveGaussianBlur(const cv::Mat& src, double sigma, int borderType = cv::BORDER_REPLICATE);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <string>
+
+// Luma-only capture.
+//
+// Eye tracking only ever needs the gray image, and YUV cameras already deliver
+// it as the Y plane. LumaCapture asks the backend for the undecoded buffer
+// (CAP_PROP_CONVERT_RGB = false) and hands out the Y plane directly, so no BGR
+// image is ever built:
+//
+//   planar 4:2:0 (I420, YV12, NV12) - view into the capture buffer, no copy
+//   packed 4:2:2 (YUYV, UYVY)       - one strided pass that keeps every other byte
+//   MJPEG                           - decoded as grayscale, chroma is skipped
+//   BGR (backend ignored the flag)  - converted with color::BGR2Gray
+//
+// Returned frames may point into the capture buffer and are only valid until the
+// next grab(); clone them to keep them around.
+
+namespace vision {
+	namespace capture {
+		enum class YuvLayout { Auto, I420, NV12, YUYV, UYVY };
+
+		// Extracts the Y plane of a raw frame of the given size. For Auto the layout
+		// is inferred from the buffer size (and fourcc when given).
+		void extractLuma(const cv::Mat& raw, cv::Mat& luma, cv::Size frameSize,
+			YuvLayout layout = YuvLayout::Auto, int fourcc = 0);
+
+		class LumaCapture {
+		public:
+			LumaCapture() = default;
+
+			// Camera or stream; width/height <= 0 keeps the device default
+			bool open(int camIndex, int width = 640, int height = 480);
+			bool open(const std::string& link);
+			// Headerless .yuv file holding back-to-back frames of one layout
+			bool openRawFile(const std::string& path, cv::Size size, YuvLayout layout = YuvLayout::I420);
+
+			bool isOpened() const;
+			void release();
+
+			bool grab();
+			bool retrieve(cv::Mat& luma);
+			bool read(cv::Mat& luma) { return grab() && retrieve(luma); }
+
+			// False when the backend ignored CONVERT_RGB and frames go through BGR2Gray
+			bool isRaw() const { return rawMode; }
+
+		private:
+			void configureRaw();
+
+			cv::VideoCapture cap;
+			std::ifstream file;
+			cv::Mat raw;
+			cv::Size size;
+			YuvLayout layout = YuvLayout::Auto;
+			int fourcc = 0;
+			bool rawMode = false;
+			bool fromFile = false;
+			bool grabbed = false;
+		};
+
+		// Frame byte size for a layout, 0 for Auto
+		size_t frameBytes(cv::Size size, YuvLayout layout);
+		// Parses "i420", "nv12", "yuyv"/"yuy2", "uyvy"; anything else is Auto
+		YuvLayout parseLayout(const std::string& name);
+	}
+}
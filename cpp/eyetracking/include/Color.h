@@ -5,5 +5,10 @@ namespace vision {
     namespace color {
         void BGR2Gray(const cv::Mat& src, cv::Mat& dst);
 		cv::Mat BGR2Gray(const cv::Mat& src);
+
+		// BGR -> gray and factor x factor box downscale (factor 1, 2 or 4) in one pass.
+		// Output is (cols / factor) x (rows / factor); leftover edge pixels are dropped.
+		void BGR2GrayDecimate(const cv::Mat& src, cv::Mat& dst, int factor);
+		cv::Mat BGR2GrayDecimate(const cv::Mat& src, int factor);
     }
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace vision {
+	namespace debug {
+		// Receives a named debug image (e.g. "selected"). Called from the worker
+		// thread, never from the detection thread.
+		using Sink = std::function<void(const std::string& name, const cv::Mat& image)>;
+
+		// Optional debug output for detectors. Off by default: callers check enabled()
+		// before building anything, post() only stores a render job, and the job runs
+		// on a background thread. Jobs that have not started yet are replaced by newer
+		// ones so a slow sink never backs up the detector.
+		class AsyncDebugSink {
+		public:
+			AsyncDebugSink() = default;
+			~AsyncDebugSink();
+
+			AsyncDebugSink(const AsyncDebugSink&) = delete;
+			AsyncDebugSink& operator=(const AsyncDebugSink&) = delete;
+
+			// Pass an empty function to detach
+			void setSink(Sink sink);
+			bool enabled() const { return hasSink.load(std::memory_order_relaxed); }
+
+			void post(const std::string& name, std::function<cv::Mat()> render);
+
+		private:
+			void workerLoop();
+
+			std::mutex mutex;
+			std::condition_variable cond;
+			std::thread worker;
+			Sink sink;
+			std::atomic<bool> hasSink{ false };
+			bool stop = false;
+
+			bool hasJob = false;
+			std::string jobName;
+			std::function<cv::Mat()> job;
+		};
+	}
+}
@@ -1,9 +1,111 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <vector>
 //#include <climits>
 
 namespace vision {
 	namespace canny {
+		// Canny with automatic thresholds as used by PuRe: 7x7 Sobel, magnitude
+		// normalized by its maximum, high threshold from the magnitude histogram
+		// (nonEdgePixelsRatio of the pixels fall below it), NMS and hysteresis.
+		//
+		// The engine owns every intermediate buffer and only reallocates them when
+		// the input size changes, so repeated calls at one working resolution do no
+		// heap allocation of their own. The returned edge map is a buffer of the
+		// engine: it may be modified in place, but the next detect() overwrites it.
+		//
+		// The gradient stage is selectable. Float is the reference pipeline. The
+		// integer modes take CV_8U input and keep CV_16S gradients, an integer L1 or
+		// rounded L2 magnitude, build the magnitude histogram in the same pass and
+		// quantize the gradient direction into a 2-bit map that NMS reads instead of
+		// re-deriving it. Integer7 is the reference kernel (response scaled by 1/16
+		// to fit 16 bits) and tracks the Float edges closely; Integer5 / Integer3
+		// are the smaller binomial derivative-of-Gaussian kernels.
+		//
+		// DerivativeOfGaussian replaces blur + 7x7 Sobel with one separable
+		// derivative-of-Gaussian pass straight from the CV_8U input: each row is
+		// smoothed and differentiated vertically in one sweep, then filtered
+		// horizontally into dx and dy. Its sigma (setDerivativeScale) is the whole
+		// smoothing, so blurImage is ignored; the default 1.75 is the closest match
+		// to the 5x5 blur + 7x7 Sobel response. The rest of the pipeline is Float.
+		//
+		// From 320x240 up, magnitude, thresholds, NMS and hysteresis are split into
+		// one row band per OpenMP thread; the edge map is the same as with one band.
+		enum class GradientMode {
+			Float,
+			Integer7,
+			Integer5,
+			Integer3,
+			DerivativeOfGaussian
+		};
+
+		class CannyEngine {
+		public:
+			void setGradientMode(GradientMode mode) { gradientMode = mode; }
+			GradientMode getGradientMode() const { return gradientMode; }
+			void setDerivativeScale(float sigma) { CV_Assert(sigma > 0); dogSigma = sigma; }
+			float getDerivativeScale() const { return dogSigma; }
+
+			const cv::Mat& detect(const cv::Mat& in, bool blurImage = false, bool useL2 = true, int bins = 64,
+				float nonEdgePixelsRatio = 0.7f, float lowHighThresholdRatio = 0.4f);
+
+			// When on, hysteresis also lists every edge pixel it accepts as a linear
+			// index (y * cols + x), in tracing order; pixels() holds the list of the
+			// last detect()
+			void setCollectPixels(bool on) { collectPixels = on; }
+			const std::vector<int>& pixels() const { return edgePixels; }
+
+		private:
+			void prepare(cv::Size size, int bins);
+			void derivatives(const cv::Mat& in, bool blurImage);
+			float magnitudeBand(int rowBegin, int rowEnd, bool useL2);
+			void normalizeBand(int rowBegin, int rowEnd, float maxMag, int* hist, int bins);
+			void thresholds(int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio, float& lowTh, float& highTh);
+			void nonMaximumSuppression(int rowBegin, int rowEnd, float lowTh, float highTh);
+			int traceStrip(int rowBegin, int rowEnd, int* stack, int* spill, std::vector<int>* accepted);
+			void traceSpill(const int* spill, int count, int* stack, std::vector<int>* accepted);
+
+			bool isIntegerMode() const {
+				return gradientMode == GradientMode::Integer7 || gradientMode == GradientMode::Integer5 || gradientMode == GradientMode::Integer3;
+			}
+
+			// Derivative-of-Gaussian gradients into dx / dy
+			void derivativeOfGaussian(const cv::Mat& in);
+
+			// Integer pipeline
+			void derivativesInt(const cv::Mat& in, bool blurImage);
+			int magnitudeBandInt(int rowBegin, int rowEnd, bool useL2, int* counts);
+			void thresholdsInt(int maxMag, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio, int& lowTh, int& highTh);
+			void nonMaximumSuppressionInt(int rowBegin, int rowEnd, int lowTh, int highTh);
+
+			// First row of band b; band b covers [bandRow(b), bandRow(b + 1))
+			int bandRow(int b) const { return static_cast<int>((long long)b * size.height / bands); }
+
+			GradientMode gradientMode = GradientMode::Float;
+			cv::Size size;
+			cv::Mat blurred;
+			cv::Mat dx, dy, magnitude;
+			cv::Mat dx16, dy16, magnitude16, direction;
+			cv::Mat edgeType, edge;
+			std::vector<int> histogram;
+			int bands = 1;                    // row bands, one per thread on large frames
+			std::vector<int> bandHistograms;  // per band, merged into histogram
+			std::vector<int> bandCounts;      // integer modes: per band, one bin per magnitude value
+			std::vector<float> bandMax;
+			float dogSigma = 1.75f;
+			float dogKernelSigma = 0;         // sigma the kernels below were built for
+			std::vector<float> dogSmooth;     // Gaussian, taps 0..r (symmetric)
+			std::vector<float> dogDerivative; // derivative, taps 0..r (antisymmetric, tap 0 unused)
+			cv::Mat dogRows;                  // two padded row buffers per thread
+			std::vector<int> traceStack;  // hysteresis, one slot per pixel
+			std::vector<int> spillBuffer; // hysteresis, per band neighbours across its edges
+			std::vector<int> bandSpilled;
+			bool collectPixels = false;
+			std::vector<std::vector<int>> bandPixels; // per band, joined into edgePixels
+			std::vector<int> edgePixels;
+		};
+
+		// One-shot wrapper; uses a per-thread engine and returns a copy of the edges
 		cv::Mat canny(const cv::Mat& in, bool blurImage = false, bool useL2 = true, int bins = 64, float nonEdgePixelsRatio = 0.7f, float lowHighThresholdRatio = 0.4f);
 	}
-}
\ No newline at end of file
+}
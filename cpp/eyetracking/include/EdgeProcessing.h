@@ -1,9 +1,126 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
 
 namespace vision {
 	namespace edge {
 		void filterEdges(cv::Mat& edges);
 		cv::Mat filterEdges(const cv::Mat& edges, cv::Mat& dst);
+
+		// PuRe's morphological edge filter (Fuhl et al. 2016c) on a bit-packed map.
+		//
+		// Same rules and same in-place raster-order semantics as PuRe::filterEdges,
+		// so the result is bit-exact with it for binary (0 / 255) edge maps. The
+		// map is held as 1 bit per pixel in 64-bit words:
+		//   - cross pruning and "too many neighbours" run a word (64 pixels) at a
+		//     time; neighbour counts are bit-sliced adders over shifted words, and
+		//     only pixels whose outcome hangs on their left neighbour are resolved
+		//     one by one
+		//   - straightening and thinning only visit set pixels; each window row is
+		//     a 7-bit pattern looked up in a per-row table of the rule terms it
+		//     satisfies, and a rule fires when its term survives the AND of all rows
+		//
+		// Buffers are kept between calls and only reallocated on a size change.
+		class EdgeFilter {
+		public:
+			void apply(cv::Mat& edges);
+
+			// Sparse variant. pixels lists every set pixel of edges as a linear index
+			// (y * cols + x) in any order, e.g. CannyEngine::pixels(). Only those
+			// pixels' 64-pixel words and the ones straightening fills are visited, so
+			// the cost follows the edge count rather than the frame area (bar one
+			// test per word to order them). Same result as apply(edges); pixels
+			// comes back as the surviving pixels in raster order. Above about 3%
+			// density it runs the whole-map passes and re-lists the survivors.
+			void apply(cv::Mat& edges, std::vector<int>& pixels);
+
+		private:
+			void resize(cv::Size size);
+			void pack(const cv::Mat& edges);
+			void unpack(cv::Mat& edges) const;
+			void straightenWord(int y, int w, std::vector<int>* filled);
+			void thinWord(int y, int w);
+
+			// Whole-map passes
+			void crossPrune();
+			void pruneCrowded();
+			void straighten();
+			void thin();
+
+			// Sparse passes over ascending word indices (y * stride + w)
+			void crossPrune(const std::vector<int>& words);
+			void pruneCrowded(const std::vector<int>& words);
+			void straighten(const std::vector<int>& words); // into visited
+			void thin(const std::vector<int>& words);
+
+			uint64_t* row(int y) { return bits.data() + (size_t)y * stride; }
+
+			cv::Size size;
+			int stride = 0;                  // words per row, one zero word of padding
+			std::vector<uint64_t> bits;
+			std::vector<uint64_t> columnMask; // columns the rules apply to
+			bool clear = true;                // bits all zero (sparse calls start from it)
+			std::vector<int> words;           // sparse: non-empty words
+			std::vector<int> visited;         // sparse: words after straightening
+			std::vector<int> filled, heap;    // sparse: words straightening filled
+		};
+
+		// Points kept per linked segment: every pixel, or only the ends of each
+		// straight chain-code run (as CHAIN_APPROX_SIMPLE)
+		enum class LinkPoints {
+			All,
+			Anchors
+		};
+
+		// Walks a thinned edge map (one pixel wide, 8-connected, e.g. EdgeFilter
+		// output) directly into ordered segments, as a replacement for findContours
+		// on it. Every edge pixel is visited once and lands in exactly one segment,
+		// so there are no doubled outlines to remove afterwards:
+		//   - a segment starts at the first unvisited pixel in raster order, is
+		//     followed to its end and then from the start in the other direction
+		//   - a step prefers 4-neighbours over diagonal ones; at a junction the
+		//     walk takes one branch and the others become segments of their own
+		//   - a segment whose ends touch is reported closed
+		//
+		// The neighbour map is padded by one pixel and returns to all-zero as the
+		// pixels are consumed, so a call costs the edge count plus, without a
+		// pixel list, one scan of the map. Buffers are kept between calls.
+		struct EdgeSegment {
+			int begin, end; // range in EdgeLinker::points()
+			bool closed;
+		};
+
+		class EdgeLinker {
+		public:
+			void link(const cv::Mat& edges, LinkPoints mode = LinkPoints::All);
+
+			// pixels lists candidate edge pixels as linear indices (y * cols + x),
+			// e.g. EdgeFilter's sparse output; entries already cleared in edges are
+			// skipped, so the map may have been masked since. Raster order gives the
+			// same segments as link(edges).
+			void link(const cv::Mat& edges, const std::vector<int>& pixels, LinkPoints mode = LinkPoints::All);
+
+			size_t count() const { return segmentList.size(); }
+			const std::vector<EdgeSegment>& segments() const { return segmentList; }
+			const std::vector<cv::Point>& points() const { return pointList; }
+			std::vector<cv::Point> segment(size_t i) const {
+				return std::vector<cv::Point>(pointList.begin() + segmentList[i].begin, pointList.begin() + segmentList[i].end);
+			}
+
+		private:
+			void resize(cv::Size size);
+			void trace(LinkPoints mode);
+			int step(int p);
+			void emit(LinkPoints mode);
+
+			cv::Size size;
+			int stride = 0;               // padded row length
+			std::vector<uchar> open;      // padded, 1 = edge pixel not yet linked
+			std::vector<int> starts;      // padded indices in raster order
+			std::vector<int> chain;       // current segment, padded indices
+			std::vector<cv::Point> pointList;
+			std::vector<EdgeSegment> segmentList;
+		};
 	}
-}
\ No newline at end of file
+}
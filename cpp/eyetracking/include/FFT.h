@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+
+// Real-input FFT used by the FFT convolution paths.
+//
+// A length-n real transform is computed as a complex transform of length n/2
+// on the even/odd samples packed as re/im, followed by a split pass. Twiddles
+// and the bit-reversal table are built once per size; plans are immutable and
+// can be shared between threads. Spectra use split storage (separate re and im
+// arrays) so the butterflies vectorize.
+//
+// The batch entry points transform kLanes lines at once. Batches are stored
+// lane-interleaved: sample t of lane l lives at [t * kLanes + l] (the same for
+// spectrum bins), which turns every butterfly into a full-width SIMD op and
+// lets a block of image columns be fed in without a transpose.
+
+namespace vision {
+	namespace fft {
+		int nextPow2(int n);
+
+		class RealFFTPlan {
+		public:
+			// n must be a power of two >= 2
+			explicit RealFFTPlan(int n);
+
+			// Returns a process-wide plan for size n, built on first use
+			static const RealFFTPlan& cached(int n);
+
+			int size() const { return n; }
+			// Number of spectrum bins, n/2 + 1
+			int bins() const { return half + 1; }
+
+			// in: n samples. re/im: bins() values each.
+			void forward(const float* in, float* re, float* im) const;
+			// re/im: bins() values each, overwritten as scratch. out: n samples.
+			// Scaled so that inverse(forward(x)) == x.
+			void inverse(float* re, float* im, float* out) const;
+
+			static constexpr int kLanes = 8;
+
+			// Same as above for kLanes interleaved lines (n * kLanes samples,
+			// bins() * kLanes values per spectrum array)
+			void forwardBatch(const float* in, float* re, float* im) const;
+			void inverseBatch(float* re, float* im, float* out) const;
+
+		private:
+			template<int L> void forwardImpl(const float* in, float* re, float* im) const;
+			template<int L> void inverseImpl(float* re, float* im, float* out) const;
+			template<int L> void butterflies(float* re, float* im) const;
+
+			int n;
+			int half;
+			std::vector<int> rev;          // bit reversal for the half-size transform
+			std::vector<float> stageRe;    // twiddles of every stage, laid out back to back
+			std::vector<float> stageIm;
+			std::vector<float> splitRe;    // exp(-2*pi*i*k/n), k <= n/4, for the real split pass
+			std::vector<float> splitIm;
+		};
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace vision {
+	namespace geometry {
+		// Diameter (largest distance between any two points) of a point set, as
+		// the O(n^2) pairwise norm loops computed it: convex hull (monotone chain,
+		// O(n log n)), then rotating calipers over its antipodal pairs. Distances
+		// are compared squared in integers and only the largest is rooted, so the
+		// value matches the pairwise loop's float(norm(...)) exactly.
+		float diameter(const std::vector<cv::Point>& points);
+
+		// The squared diameter, exact, for callers that compare in double
+		int64_t squaredDiameter(const std::vector<cv::Point>& points);
+
+		// O(n) early-out: the diameter is at least the longer side of the bounding
+		// box, so a side of limit or more means diameter(points) >= limit too
+		bool boundingBoxExceeds(const std::vector<cv::Point>& points, double limit);
+	}
+}
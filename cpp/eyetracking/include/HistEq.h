@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <opencv2/opencv.hpp>
 
@@ -11,8 +12,54 @@ namespace vision {
          * @param dst Output image (CV_8UC1)
          * @param clipLimit Maximum contrast clip limit (>1 means contrast limited)
          * @param tileGridSize Size of grid, e.g., cv::Size(8,8)
+         *
+         * Tile histograms are built in parallel into one flat LUT array; the
+         * bilinear blend between tile LUTs is fixed-point (Q11) and row-parallel.
+         * Pixels outside the outermost tile centres use the nearest tile only.
+         * dst may be the same Mat as src.
          */
         void CLAHE(const cv::Mat& src, cv::Mat& dst, double clipLimit, cv::Size tileGridSize);
 		cv::Mat CLAHE(const cv::Mat& src, double clipLimit, cv::Size tileGridSize);
+
+		/**
+		 * @brief CLAHE for video that keeps tile histograms and LUTs between frames
+		 *
+		 * Each frame a tile's histogram is sampled (every 4th row, 32 bins) and
+		 * compared with the one its LUT was built from. Only tiles whose L1 distance
+		 * exceeds rebuildThreshold (fraction of the sampled pixels, 0..1) get a full
+		 * histogram and a new LUT; the rest reuse their LUT. With lutBlend > 0 a
+		 * rebuilt tile moves towards its new LUT exponentially (new = blend * old +
+		 * (1 - blend) * target per frame) instead of switching at once.
+		 *
+		 * A change of image size resets the state. Output equals CLAHE() on frames
+		 * where every tile is rebuilt without blending. That is not cv::CLAHE's
+		 * output: the clip remainder, LUT rounding and tile padding differ.
+		 */
+		class TemporalCLAHE {
+		public:
+			TemporalCLAHE(double clipLimit = 2.0, cv::Size tileGridSize = cv::Size(8, 8),
+				double rebuildThreshold = 0.1, double lutBlend = 0.0);
+
+			void apply(const cv::Mat& src, cv::Mat& dst);
+			// Drop all tile state; the next frame is processed from scratch
+			void reset();
+
+			// Tiles whose LUT was rebuilt by the last apply()
+			int lastRebuiltTiles() const { return rebuilt; }
+
+		private:
+			double clipLimit;
+			cv::Size tileGridSize;
+			double rebuildThreshold;
+			int blendWeight;               // weight of the old LUT, Q8
+
+			cv::Size imageSize;
+			std::vector<int> refHist;      // sampled coarse histogram each LUT was built from
+			std::vector<uchar> target;     // LUT from the last rebuild, 256 per tile
+			std::vector<uint16_t> state;   // applied LUT in Q8 while blending
+			std::vector<uchar> luts;       // applied LUT, flat like CLAHE()
+			std::vector<uchar> settling;   // per tile: still blending towards target
+			int rebuilt;
+		};
 	}
 }
\ No newline at end of file
@@ -9,6 +9,9 @@ namespace vision {
         constexpr int NORM_L2 = 4;
         constexpr int NORM_MINMAX = 32;
 
+        // Same semantics as a per-element (v - min) / (max - min) * (beta - alpha) + alpha
+        // (MINMAX) or v / norm * alpha, truncated to the source type. 8-bit inputs
+        // go through a 256-entry LUT; reductions are SIMD and row-parallel.
         void normalize(const cv::Mat& src,
             cv::Mat& dst,
             double alpha = -1, // if -1, auto set based on type
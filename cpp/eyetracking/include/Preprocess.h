@@ -1,5 +1,6 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include "HistEq.h"
 
 namespace vision {
 	namespace pre {
@@ -28,6 +29,16 @@ namespace vision {
 			double sigmaSpace = 7.0,
 			double unsharpAmount = 1.2,
 			double unsharpSigma = 1.0);
+
+		// Same pipeline for video: CLAHE goes through a caller-owned TemporalCLAHE
+		// so unchanged tiles keep their LUTs from the previous frame
+		cv::Mat enhanceForPupil(const cv::Mat& gray,
+			vision::histeq::TemporalCLAHE& clahe,
+			int bilateralDiameter = 7,
+			double sigmaColor = 50.0,
+			double sigmaSpace = 7.0,
+			double unsharpAmount = 1.2,
+			double unsharpSigma = 1.0);
 	}
 }
 
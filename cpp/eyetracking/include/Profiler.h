@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Per-stage latency instrumentation.
+//
+// Timers are only compiled in when VISION_ENABLE_PROFILING is defined; otherwise
+// VISION_PROFILE_SCOPE expands to nothing and the registry below just reports
+// empty histograms.
+
+namespace vision {
+	namespace profile {
+		enum class Stage : int {
+			Total = 0,
+			Resize,
+			Flip,
+			CvtColor,
+			Haar,
+			RoiResize,
+			Morphology,
+			Enhance,
+			Detect,
+			Validate,
+			Smooth,
+			Count
+		};
+
+		const char* stageName(Stage stage);
+
+		// Fixed-size log2 histogram of durations in nanoseconds.
+		// Four buckets per octave from 256 ns up to ~1 s; anything outside lands in
+		// the first/last bucket. Recording is lock-free (relaxed atomics).
+		class LatencyHistogram {
+		public:
+			static constexpr int kSubBuckets = 4;
+			static constexpr int kMinLog2 = 8;   // 256 ns
+			static constexpr int kMaxLog2 = 30;  // ~1.07 s
+			static constexpr int kBuckets = (kMaxLog2 - kMinLog2) * kSubBuckets;
+
+			LatencyHistogram() { reset(); }
+
+			void record(uint64_t ns);
+			void reset();
+
+			uint64_t count() const { return total.load(std::memory_order_relaxed); }
+			double meanMs() const;
+			double minMs() const;
+			double maxMs() const;
+			// p in [0, 100], interpolated inside the matching bucket
+			double percentileMs(double p) const;
+
+			// Bucket bounds in nanoseconds
+			static double bucketLower(int b);
+			static double bucketUpper(int b);
+
+		private:
+			std::atomic<uint64_t> buckets[kBuckets];
+			std::atomic<uint64_t> total;
+			std::atomic<uint64_t> sumNs;
+			std::atomic<uint64_t> minNs;
+			std::atomic<uint64_t> maxNs;
+		};
+
+		class Profiler {
+		public:
+			static Profiler& instance();
+
+			void record(Stage stage, uint64_t ns) { hist[(int)stage].record(ns); }
+			void reset();
+
+			const LatencyHistogram& histogram(Stage stage) const { return hist[(int)stage]; }
+
+			// {"enabled":..., "stages":{"resize":{"count":..,"mean_ms":..,"p50_ms":..}, ...}}
+			std::string toJson() const;
+			bool writeJson(const std::string& path) const;
+
+		private:
+			Profiler() = default;
+			LatencyHistogram hist[(int)Stage::Count];
+		};
+
+		class ScopedTimer {
+		public:
+			explicit ScopedTimer(Stage stage)
+				: stage(stage), start(std::chrono::steady_clock::now()) {}
+			~ScopedTimer() {
+				auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+				Profiler::instance().record(stage, (uint64_t)ns);
+			}
+			ScopedTimer(const ScopedTimer&) = delete;
+			ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+		private:
+			Stage stage;
+			std::chrono::steady_clock::time_point start;
+		};
+
+#ifdef VISION_ENABLE_PROFILING
+		static constexpr bool kEnabled = true;
+#else
+		static constexpr bool kEnabled = false;
+#endif
+	}
+}
+
+#define VISION_PROFILE_CONCAT_(a, b) a##b
+#define VISION_PROFILE_CONCAT(a, b) VISION_PROFILE_CONCAT_(a, b)
+
+#ifdef VISION_ENABLE_PROFILING
+#define VISION_PROFILE_SCOPE(stage) \
+	::vision::profile::ScopedTimer VISION_PROFILE_CONCAT(_visionProfileTimer, __LINE__)(::vision::profile::Stage::stage)
+#else
+#define VISION_PROFILE_SCOPE(stage) do {} while (0)
+#endif
@@ -47,6 +47,9 @@
 
 #include "haarcascade.h"
 #include "Detector.h"
+#include "DebugSink.h"
+#include "EdgeDetection.h"
+#include "EdgeProcessing.h"
 
 class PupilCandidate
 {
@@ -204,6 +207,19 @@ public:
     bool hasCoarseLocation() { return false; }
     static std::string desc;
 
+    // Debug images ("selected") are only rendered while a sink is attached,
+    // on a background thread. Pass an empty function to detach.
+    void setDebugSink(vision::debug::Sink sink) { debugSink.setSink(std::move(sink)); }
+
+    // Opt into the integer Canny gradients (Float keeps the reference pipeline)
+    void setCannyGradient(vision::canny::GradientMode mode) { cannyEngine.setGradientMode(mode); }
+
+    // Link edge segments straight from the filtered edges (EdgeLinker) instead
+    // of findContours + removeDuplicates. Off by default: the linker keeps
+    // straight-run anchors rather than TC89_KCOS points, splits curves at
+    // junctions and lists each pixel once, so candidate curves differ
+    void setEdgeLinking(bool on) { linkEdges = on; }
+
     float meanCanthiDistanceMM;
     float maxPupilDiameterMM;
     float minPupilDiameterMM;
@@ -236,6 +252,8 @@ protected:
     cv::Size baseSize;
     cv::Size workingSize;
     float scalingRatio;
+    cv::Mat downscaled;
+    void downscaleInput(const cv::Mat& frame);
 
     /*
      *  Detection
@@ -243,26 +261,54 @@ protected:
     void detect(Pupil& pupil);
     void detect(Pupil& pupil, const cv::Mat& fullFrame);
 
-    // Canny
-    cv::Mat dx, dy, magnitude;
-    cv::Mat edgeType, edge;
+    // Canny (workspace lives in the engine, reused across frames)
+    vision::canny::CannyEngine cannyEngine;
     cv::Mat canny(const cv::Mat& in, bool blur = true, bool useL2 = true, int bins = 64, float nonEdgePixelsRatio = 0.7f, float lowHighThresholdRatio = 0.4f);
 
-    // Edge filtering
+    // Edge filtering (bit-packed workspace reused across frames). edges must be
+    // the map canny() just returned: its pixel list drives the sparse passes, and
+    // edgePixels holds the surviving pixels (y * cols + x) in raster order
+    vision::edge::EdgeFilter edgeFilter;
+    std::vector<int> edgePixels;
     void filterEdges(cv::Mat& edges);
 
-    // Remove duplicates (e.g., from closed loops)
+    // Segment extraction from the filtered edges (see vision::edge::EdgeLinker)
+    vision::edge::EdgeLinker edgeLinker;
+    bool linkEdges = false;
+
+    // Remove duplicates (e.g., from closed loops). From the last curve back,
+    // a curve is dropped when its first point is already claimed, otherwise it
+    // claims all its points; survivors keep their order. The claimed bitmap is
+    // kept across frames and cleared again through the surviving curves.
     int pointHash(cv::Point p, int cols) { return p.y * cols + p.x; }
+    std::vector<uchar> claimedPoints;
+    std::vector<uchar> keptCurves;
     void removeDuplicates(std::vector<std::vector<cv::Point> >& curves, const int& cols) {
-        std::map<int, uchar> contourMap;
+        keptCurves.assign(curves.size(), 0);
         for (size_t i = curves.size(); i-- > 0;) {
-            if (contourMap.count(pointHash(curves[i][0], cols)) > 0)
-                curves.erase(curves.begin() + i);
-            else {
-                for (int j = 0; j < curves[i].size(); j++)
-                    contourMap[pointHash(curves[i][j], cols)] = 1;
+            const int first = pointHash(curves[i][0], cols);
+            if (first < (int)claimedPoints.size() && claimedPoints[first])
+                continue;
+            keptCurves[i] = 1;
+            for (const cv::Point& p : curves[i]) {
+                const int h = pointHash(p, cols);
+                if (h >= (int)claimedPoints.size())
+                    claimedPoints.resize(h + 1, 0);
+                claimedPoints[h] = 1;
             }
         }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < curves.size(); i++) {
+            if (!keptCurves[i])
+                continue;
+            for (const cv::Point& p : curves[i])
+                claimedPoints[pointHash(p, cols)] = 0;
+            if (kept != i)
+                curves[kept] = std::move(curves[i]);
+            kept++;
+        }
+        curves.resize(kept);
     }
 
     void findPupilEdgeCandidates(const cv::Mat& intensityImage, cv::Mat& edge, std::vector<PupilCandidate>& candidates);
@@ -272,6 +318,9 @@ protected:
     cv::Mat input;
     cv::Mat dbg;
 
+    vision::debug::AsyncDebugSink debugSink;
+    void postSelectedDebug(const PupilCandidate* selected);
+
     int maxCanthiDistancePx;
     int minCanthiDistancePx;
     int maxPupilDiameterPx;
@@ -5,6 +5,8 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "EdgeDetection.h"
+
 namespace pure_old {
 	struct Parameters{
 		// Either set auto_pupil_diameter = true or specify min/max.
@@ -50,6 +52,7 @@ namespace pure_old {
 	private:
 		//Edge detection and Morphological Manipulation
 		cv::Mat edge_img;
+		vision::canny::CannyEngine canny_engine;
 		void detect_edges();
 
 	private: 
@@ -18,18 +18,30 @@ namespace vision {
 			
 			// Process a frame and return detected pupil
 			// Returns the smoothed/validated pupil if available, otherwise raw detection
+			// frame is either BGR or single-channel gray/luma (see Capture.h); gray
+			// frames skip colour conversion entirely
 			Pupil processFrame(const cv::Mat& frame, bool useHaar = false);
 			
 			// Reset state (e.g., when relocking Haar)
 			void reset();
 			
-			// Get current working region (for visualization)
-			cv::Mat getWorkingFrame() const { return workingFrame.clone(); }
+			// Get current working region (for visualization), always BGR
+			// Rendered on demand from the last input frame, so call it before that
+			// frame's buffer is reused (e.g. the next capture)
+			cv::Mat getWorkingFrame() const;
 			// Get last pupil in working-frame coordinates (matches getWorkingFrame)
 			Pupil getWorkingPupil() const { return lastWorkingPupil; }
 			
 			// Check if Haar is currently locked
 			bool isHaarLocked() const { return haarLocked; }
+
+			// Opt into TemporalCLAHE (tile LUTs kept across frames). Off by default:
+			// its clip and LUT rounding differ from cv::CLAHE, which the detector
+			// thresholds were tuned on
+			void setTemporalCLAHE(bool on) { useTemporalClahe = on; clahe.reset(); }
+
+			// Attach a debug image sink to the PuRe detector (off by default)
+			void setDebugSink(vision::debug::Sink sink) { detector.setDebugSink(std::move(sink)); }
 			
 			// Transform pupil coordinates from working space to original frame space
 			// Returns pupil with coordinates in the resized frame space (not original)
@@ -39,6 +51,8 @@ namespace vision {
 			PuRe detector;
 			PuReST purest;
 			vision::haar::EyeZoomer zoomer;
+			vision::histeq::TemporalCLAHE clahe; // keeps tile LUTs across frames
+			bool useTemporalClahe;
 			
 			bool haarLocked;
 			cv::Rect lockedRoi;
@@ -50,7 +64,7 @@ namespace vision {
 			Pupil smoothPupil;
 			bool hasSmooth;
 			
-			cv::Mat workingFrame;
+			cv::Mat viewSource;    // last resized input (unmirrored), for getWorkingFrame
 			cv::Mat workingGray;
 			Pupil lastWorkingPupil;
 			
@@ -15,5 +15,11 @@ namespace vision {
 		constexpr int INTER_CUBIC = 3;
         void resize(const cv::Mat& src, cv::Mat& dst, cv::Size dsize, double fx = 0, double fy = 0, int interpolation = INTER_LINEAR);
         cv::Mat resize(const cv::Mat& src, cv::Size dsize, double fx = 0, double fy = 0, int interpolation = INTER_LINEAR);
+
+        // Bilinear resize of an 8-bit single-channel image by (fx, fy) followed by a
+        // min-max stretch to [0, 255], in one pass over the output plus a LUT remap.
+        // Equivalent to resize(INTER_LINEAR) + normalize(0, 255, NORM_MINMAX, CV_8U).
+        // dst is reused when it already has the right size.
+        void resizeNormalize(const cv::Mat& src, cv::Mat& dst, double fx, double fy);
     }
 }
\ No newline at end of file
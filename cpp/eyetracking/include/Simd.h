@@ -0,0 +1,34 @@
+#pragma once
+
+// Compile-time SIMD detection for the hand-written kernels.
+// Each level implies the ones below it. Kernels must always keep a scalar path.
+//
+//   VISION_SIMD_SSE2   - x64 / SSE2 builds (always on for MSVC x64)
+//   VISION_SIMD_SSSE3  - byte shuffles (pshufb)
+//   VISION_SIMD_AVX2   - 256-bit integer ops (/arch:AVX2 or -mavx2)
+//
+// Define VISION_DISABLE_SIMD to force the scalar paths (useful for equivalence tests).
+
+#ifndef VISION_DISABLE_SIMD
+
+#if defined(__AVX2__)
+#define VISION_SIMD_AVX2 1
+#endif
+
+#if defined(VISION_SIMD_AVX2) || defined(__SSSE3__) || (defined(_MSC_VER) && defined(__AVX__))
+#define VISION_SIMD_SSSE3 1
+#endif
+
+#if defined(VISION_SIMD_SSSE3) || defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VISION_SIMD_SSE2 1
+#endif
+
+#endif // VISION_DISABLE_SIMD
+
+#if defined(VISION_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(VISION_SIMD_SSSE3)
+#include <tmmintrin.h>
+#elif defined(VISION_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
@@ -1,7 +1,11 @@
 #include "Blur.h"
 #include "Utils.h"
+#include "Simd.h"
+#include "FFT.h"
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
 #include <omp.h>
 
@@ -22,6 +26,167 @@ namespace vision {
             for (int i = 0; i < len; ++i) kernel[i] = static_cast<float>(kernel[i] / sum);
         }
 
+        // ------------------------------------------------------------------
+        // 8-bit fixed-point path
+        // Weights are Q8 and sum to exactly 256. The horizontal pass keeps the
+        // full 16-bit sum (<= 255 * 256), the vertical pass accumulates in 32 bits
+        // and the result is rounded once with >> 16.
+        // ------------------------------------------------------------------
+        static void makeFixedKernel(const std::vector<float>& kernel, std::vector<uint16_t>& fixed) {
+            const int len = static_cast<int>(kernel.size());
+            const int radius = len / 2;
+            fixed.resize(len);
+            int sum = 0;
+            for (int i = 0; i < len; ++i) {
+                fixed[i] = static_cast<uint16_t>(std::lround(kernel[i] * 256.0));
+                sum += fixed[i];
+            }
+            // rounding error goes to the centre tap so the kernel stays symmetric
+            fixed[radius] = static_cast<uint16_t>(fixed[radius] + (256 - sum));
+        }
+
+        // center points at the first real pixel of a row padded by radius pixels on both sides
+        static void blurRowH8u(const uchar* center, uint16_t* dst, int width, int cn, const uint16_t* w, int radius) {
+            int x = 0;
+#if defined(VISION_SIMD_AVX2)
+            for (; x <= width - 16; x += 16) {
+                __m256i acc = _mm256_mullo_epi16(
+                    _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(center + x))),
+                    _mm256_set1_epi16((short)w[radius]));
+                for (int k = 1; k <= radius; ++k) {
+                    __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(center + x - k * cn)));
+                    __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(center + x + k * cn)));
+                    acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(_mm256_add_epi16(a, b), _mm256_set1_epi16((short)w[radius + k])));
+                }
+                _mm256_storeu_si256((__m256i*)(dst + x), acc);
+            }
+#endif
+#if defined(VISION_SIMD_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for (; x <= width - 8; x += 8) {
+                __m128i acc = _mm_mullo_epi16(
+                    _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(center + x)), zero),
+                    _mm_set1_epi16((short)w[radius]));
+                for (int k = 1; k <= radius; ++k) {
+                    __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(center + x - k * cn)), zero);
+                    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(center + x + k * cn)), zero);
+                    acc = _mm_add_epi16(acc, _mm_mullo_epi16(_mm_add_epi16(a, b), _mm_set1_epi16((short)w[radius + k])));
+                }
+                _mm_storeu_si128((__m128i*)(dst + x), acc);
+            }
+#endif
+            for (; x < width; ++x) {
+                unsigned acc = center[x] * w[radius];
+                for (int k = 1; k <= radius; ++k)
+                    acc += (center[x - k * cn] + center[x + k * cn]) * w[radius + k];
+                dst[x] = static_cast<uint16_t>(acc);
+            }
+        }
+
+        // rows holds the 2*radius+1 (already border-resolved) source rows for this output row
+        static void blurColV8u(const uint16_t* const* rows, uchar* dst, int width, const uint16_t* w, int klen) {
+            int x = 0;
+#if defined(VISION_SIMD_AVX2)
+            const __m256i round256 = _mm256_set1_epi32(1 << 15);
+            for (; x <= width - 16; x += 16) {
+                __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+                for (int k = 0; k < klen; ++k) {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)(rows[k] + x));
+                    __m256i wk = _mm256_set1_epi16((short)w[k]);
+                    __m256i pl = _mm256_mullo_epi16(v, wk);
+                    __m256i ph = _mm256_mulhi_epu16(v, wk);
+                    lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(pl, ph));
+                    hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(pl, ph));
+                }
+                lo = _mm256_srli_epi32(_mm256_add_epi32(lo, round256), 16);
+                hi = _mm256_srli_epi32(_mm256_add_epi32(hi, round256), 16);
+                __m256i p8 = _mm256_packus_epi16(_mm256_packs_epi32(lo, hi), _mm256_setzero_si256());
+                p8 = _mm256_permute4x64_epi64(p8, _MM_SHUFFLE(3, 1, 2, 0));
+                _mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(p8));
+            }
+#endif
+#if defined(VISION_SIMD_SSE2)
+            const __m128i round128 = _mm_set1_epi32(1 << 15);
+            for (; x <= width - 8; x += 8) {
+                __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+                for (int k = 0; k < klen; ++k) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(rows[k] + x));
+                    __m128i wk = _mm_set1_epi16((short)w[k]);
+                    __m128i pl = _mm_mullo_epi16(v, wk);
+                    __m128i ph = _mm_mulhi_epu16(v, wk);
+                    lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(pl, ph));
+                    hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(pl, ph));
+                }
+                lo = _mm_srli_epi32(_mm_add_epi32(lo, round128), 16);
+                hi = _mm_srli_epi32(_mm_add_epi32(hi, round128), 16);
+                __m128i p16 = _mm_packs_epi32(lo, hi);
+                _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(p16, p16));
+            }
+#endif
+            for (; x < width; ++x) {
+                uint32_t acc = 0;
+                for (int k = 0; k < klen; ++k)
+                    acc += static_cast<uint32_t>(rows[k][x]) * w[k];
+                dst[x] = static_cast<uchar>((acc + (1u << 15)) >> 16);
+            }
+        }
+
+        static void gaussianBlur8U(const cv::Mat& src, cv::Mat& dst, const std::vector<float>& kernel, int radius, int borderType) {
+            if (borderType != cv::BORDER_REFLECT && borderType != cv::BORDER_REFLECT_101 && borderType != cv::BORDER_WRAP)
+                borderType = cv::BORDER_REPLICATE;
+
+            std::vector<uint16_t> w;
+            makeFixedKernel(kernel, w);
+
+            const int rows = src.rows;
+            const int cols = src.cols;
+            const int cn = src.channels();
+            const int width = cols * cn;
+            const int klen = 2 * radius + 1;
+
+            // Border handling is resolved once into index tables, so the inner
+            // loops never branch on the border policy
+            std::vector<int> xofs(cols + 2 * radius);
+            for (int i = 0; i < (int)xofs.size(); ++i)
+                xofs[i] = cv::borderInterpolate(i - radius, cols, borderType) * cn;
+            std::vector<int> yofs(rows + 2 * radius);
+            for (int i = 0; i < (int)yofs.size(); ++i)
+                yofs[i] = cv::borderInterpolate(i - radius, rows, borderType);
+
+            // Horizontal pass (parallel over rows) into 16-bit fixed point
+            cv::Mat tmp(rows, width, CV_16UC1);
+#pragma omp parallel
+            {
+                std::vector<uchar> pad((cols + 2 * radius) * cn);
+#pragma omp for schedule(static)
+                for (int y = 0; y < rows; ++y) {
+                    const uchar* srcRow = src.ptr<uchar>(y);
+                    uchar* p = pad.data();
+                    for (int i = 0; i < radius; ++i)
+                        for (int c = 0; c < cn; ++c)
+                            p[i * cn + c] = srcRow[xofs[i] + c];
+                    std::memcpy(p + radius * cn, srcRow, width);
+                    for (int i = radius + cols; i < cols + 2 * radius; ++i)
+                        for (int c = 0; c < cn; ++c)
+                            p[i * cn + c] = srcRow[xofs[i] + c];
+                    blurRowH8u(p + radius * cn, tmp.ptr<uint16_t>(y), width, cn, w.data(), radius);
+                }
+            }
+
+            // Vertical pass (parallel over rows); src is no longer read, so dst may alias it
+            dst.create(rows, cols, src.type());
+#pragma omp parallel
+            {
+                std::vector<const uint16_t*> rowPtrs(klen);
+#pragma omp for schedule(static)
+                for (int y = 0; y < rows; ++y) {
+                    for (int k = 0; k < klen; ++k)
+                        rowPtrs[k] = tmp.ptr<uint16_t>(yofs[y + k]);
+                    blurColV8u(rowPtrs.data(), dst.ptr<uchar>(y), width, w.data(), klen);
+                }
+            }
+        }
+
         void GaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int radius, int borderType) {
             if (src.empty()) {
                 dst = src.clone();
@@ -46,6 +211,11 @@ namespace vision {
             std::vector<float> kernel;
             makeGaussianKernel(sigma, radius, kernel);
 
+            if (src.depth() == CV_8U) {
+                gaussianBlur8U(src, dst, kernel, radius, borderType);
+                return;
+            }
+
             // convert to float for processing
             cv::Mat srcF;
             src.convertTo(srcF, CV_32F);
@@ -124,226 +294,354 @@ namespace vision {
             return dst;
 		}
 
-        using Complex = std::complex<double>;
+        // ------------------------------------------------------------------
+        // FFT path
+        // Each line is extended by the kernel radius on both sides and
+        // circularly convolved with the centred kernel, so a transform length
+        // of nextPow2(n + 2 * radius) is enough. Lines go through the real FFT
+        // kLanes at a time: for the vertical pass the lanes are neighbouring
+        // columns (read straight from the rows), for the horizontal pass they
+        // are neighbouring rows gathered as a small transposed block.
+        // ------------------------------------------------------------------
+        static void fftConvolveLines(const cv::Mat& src, cv::Mat& dst, const std::vector<float>& kernel,
+            int radius, int borderType, bool vertical) {
+            const int L = fft::RealFFTPlan::kLanes;
+            const int n = vertical ? src.rows : src.cols;
+            const int lanes = vertical ? src.cols : src.rows;
+            const int extLen = n + 2 * radius;
+            const fft::RealFFTPlan& plan = fft::RealFFTPlan::cached(std::max(2, fft::nextPow2(extLen)));
+            const int N = plan.size();
+            const int bins = plan.bins();
+
+            // Kernel spectrum. The kernel is symmetric, so it is real.
+            std::vector<float> H(bins);
+            {
+                std::vector<float> h(N, 0.0f), re(bins), im(bins);
+                for (int m = 0; m <= radius; ++m) {
+                    h[m % N] += kernel[radius + m];
+                    if (m > 0) h[(N - m) % N] += kernel[radius - m];
+                }
+                plan.forward(h.data(), re.data(), im.data());
+                H = re;
+            }
 
-        static inline int nextPow2(int n) {
-            int p = 1;
-            while (p < n) p <<= 1;
-            return p;
-        }
+            std::vector<int> ext(extLen);
+            for (int t = 0; t < extLen; ++t)
+                ext[t] = cv::borderInterpolate(t - radius, n, borderType);
+
+            dst.create(src.size(), CV_32FC1);
+            const int batches = (lanes + L - 1) / L;
+#pragma omp parallel
+            {
+                std::vector<float> line((size_t)N * L), re((size_t)bins * L), im((size_t)bins * L);
+                const float* rowIn[fft::RealFFTPlan::kLanes];
+                float* rowOut[fft::RealFFTPlan::kLanes];
+#pragma omp for schedule(static)
+                for (int b = 0; b < batches; ++b) {
+                    const int l0 = b * L;
+                    const int count = std::min(L, lanes - l0);
+                    if (!vertical) {
+                        for (int l = 0; l < count; ++l) {
+                            rowIn[l] = src.ptr<float>(l0 + l);
+                            rowOut[l] = dst.ptr<float>(l0 + l);
+                        }
+                    }
 
-        static void bitReverse(std::vector<Complex>& a) {
-            int n = static_cast<int>(a.size());
-            int j = 0;
-            for (int i = 1; i < n; ++i) {
-                int bit = n >> 1;
-                for (; j & bit; bit >>= 1)
-                    j ^= bit;
-                j ^= bit;
-                if (i < j)
-                    std::swap(a[i], a[j]);
-            }
-        }
+                    std::fill(line.begin(), line.end(), 0.0f);
+                    for (int t = 0; t < extLen; ++t) {
+                        int e = ext[t];
+                        if (e < 0) continue;  // BORDER_CONSTANT, zero
+                        float* d = line.data() + (size_t)t * L;
+                        if (vertical) {
+                            const float* s = src.ptr<float>(e) + l0;
+                            for (int l = 0; l < count; ++l) d[l] = s[l];
+                        }
+                        else {
+                            for (int l = 0; l < count; ++l) d[l] = rowIn[l][e];
+                        }
+                    }
 
-        static void fft(std::vector<Complex>& a, bool invert) {
-            int n = static_cast<int>(a.size());
-            bitReverse(a);
-
-            for (int len = 2; len <= n; len <<= 1) {
-                double ang = 2 * M_PI / len * (invert ? -1 : 1);
-                Complex wlen(std::cos(ang), std::sin(ang));
-
-                for (int i = 0; i < n; i += len) {
-                    Complex w(1);
-                    for (int j = 0; j < len / 2; ++j) {
-                        Complex u = a[i + j];
-                        Complex v = a[i + j + len / 2] * w;
-                        a[i + j] = u + v;
-                        a[i + j + len / 2] = u - v;
-                        w *= wlen;
+                    plan.forwardBatch(line.data(), re.data(), im.data());
+                    for (int k = 0; k < bins; ++k) {
+                        const float g = H[k];
+                        float* r = re.data() + (size_t)k * L;
+                        float* m = im.data() + (size_t)k * L;
+                        for (int l = 0; l < L; ++l) {
+                            r[l] *= g;
+                            m[l] *= g;
+                        }
                     }
-                }
-            }
+                    plan.inverseBatch(re.data(), im.data(), line.data());
 
-            if (invert) {
-                for (auto& x : a) x /= n;
+                    for (int i = 0; i < n; ++i) {
+                        const float* s = line.data() + (size_t)(i + radius) * L;
+                        if (vertical) {
+                            float* d = dst.ptr<float>(i) + l0;
+                            for (int l = 0; l < count; ++l) d[l] = s[l];
+                        }
+                        else {
+                            for (int l = 0; l < count; ++l) rowOut[l][i] = s[l];
+                        }
+                    }
+                }
             }
         }
 
-        static std::vector<double> makeGaussian1D(int size, double sigma) {
-            std::vector<double> kernel(size);
-            double sigma2 = 2.0 * sigma * sigma;
-            int half = size / 2;
-            double sum = 0.0;
-            for (int i = 0; i < size; ++i) {
-                double x = i - half;
-                kernel[i] = std::exp(-(x * x) / sigma2);
-                sum += kernel[i];
-            }
-            for (double& k : kernel)
-                k /= sum;
-            return kernel;
-        }
+        cv::Mat FFTGaussianBlur(const cv::Mat& src, double sigma, int borderType) {
+            CV_Assert(src.channels() == 1 || src.channels() == 3);
+            if (src.empty() || sigma <= 0.0)
+                return src.clone();
 
-        static cv::Mat reflectPad(const cv::Mat& src, int pad) {
-            cv::Mat dst;
-            cv::copyMakeBorder(src, dst, pad, pad, pad, pad, cv::BORDER_REFLECT);
-            return dst;
-        }
+            int kernelRadius = std::max(1, static_cast<int>(std::ceil(3 * sigma)));
+            std::vector<float> kernel;
+            makeGaussianKernel(sigma, kernelRadius, kernel);
 
-        /*static void convolve1DFFT(cv::Mat& img, const std::vector<double>& kernel, bool horizontal) {
-            int rows = img.rows;
-            int cols = img.cols;
-            int n = horizontal ? cols : rows;
-            int k = static_cast<int>(kernel.size());
-            int fftSize = nextPow2(n + k - 1);
+            auto processChannel = [&](const cv::Mat& channel) {
+                cv::Mat f, tmp, out, result;
+                channel.convertTo(f, CV_32F);
+                fftConvolveLines(f, tmp, kernel, kernelRadius, borderType, true);
+                fftConvolveLines(tmp, out, kernel, kernelRadius, borderType, false);
+                out.convertTo(result, channel.type());
+                return result;
+                };
 
-            std::vector<Complex> kernelFFT(fftSize);
-            for (int i = 0; i < k; ++i)
-                kernelFFT[i] = kernel[i];
-            for (int i = k; i < fftSize; ++i)
-                kernelFFT[i] = 0.0;
-            fft(kernelFFT, false);
+            cv::Mat result;
+            if (src.channels() == 1) {
+                result = processChannel(src);
+            }
+            else {
+                std::vector<cv::Mat> channels;
+                cv::split(src, channels);
+                for (int i = 0; i < 3; ++i)
+                    channels[i] = processChannel(channels[i]);
+                cv::merge(channels, result);
+            }
 
-            std::vector<Complex> A(fftSize);
+            return result;
+        }
 
-            if (horizontal) {
-                for (int y = 0; y < rows; ++y) {
-                    for (int i = 0; i < n; ++i)
-                        A[i] = static_cast<double>(img.at<uchar>(y, i));
-                    for (int i = n; i < fftSize; ++i)
-                        A[i] = 0.0;
+        // ------------------------------------------------------------------
+        // Recursive (IIR) Gaussian, Young & van Vliet 1995 with the
+        // Triggs & Sdika 2006 boundary initialisation. A causal and an
+        // anti-causal 3rd order pass per axis: 6 multiply-adds per pixel per
+        // axis regardless of sigma.
+        // ------------------------------------------------------------------
+        struct RecursiveCoeffs {
+            float B;
+            float a1, a2, a3;
+            float M[9];  // anti-causal initial state for a replicated right border
+            int pad;     // extension used for the other border types
+        };
+
+        static RecursiveCoeffs makeRecursiveCoeffs(double sigma) {
+            // the q(sigma) fit is only valid from 0.5 upwards
+            sigma = std::max(sigma, 0.5);
+            double q = (sigma >= 2.5) ? 0.98711 * sigma - 0.96330
+                : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+            double q2 = q * q, q3 = q2 * q;
+            double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+            double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+            double b2 = -(1.4281 * q2 + 1.26661 * q3);
+            double b3 = 0.422205 * q3;
+            double a1 = b1 / b0, a2 = b2 / b0, a3 = b3 / b0;
+            double B = 1.0 - (a1 + a2 + a3);
+
+            // Triggs & Sdika matrix, scaled by B because both passes carry the gain
+            double sc = B / ((1.0 + a1 - a2 + a3) * (1.0 - a1 - a2 - a3) * (1.0 + a2 + (a1 - a3) * a3));
+            double M[9] = {
+                -a3 * a1 + 1.0 - a3 * a3 - a2,
+                (a3 + a1) * (a2 + a3 * a1),
+                a3 * (a1 + a3 * a2),
+                a1 + a3 * a2,
+                -(a2 - 1.0) * (a2 + a3 * a1),
+                -a3 * (a3 * a1 + a3 * a3 + a2 - 1.0),
+                a3 * a1 + a2 + a1 * a1 - a2 * a2,
+                a1 * a2 + a3 * a2 * a2 - a1 * a3 * a3 - a3 * a3 * a3 - a3 * a2 + a3,
+                a3 * (a1 + a3 * a2)
+            };
+
+            RecursiveCoeffs c;
+            c.B = static_cast<float>(B);
+            c.a1 = static_cast<float>(a1);
+            c.a2 = static_cast<float>(a2);
+            c.a3 = static_cast<float>(a3);
+            for (int i = 0; i < 9; ++i) c.M[i] = static_cast<float>(sc * M[i]);
+            c.pad = std::max(3, static_cast<int>(std::ceil(4.0 * sigma)));
+            return c;
+        }
 
-                    fft(A, false);
-                    for (int i = 0; i < fftSize; ++i)
-                        A[i] *= kernelFFT[i];
-                    fft(A, true);
+        // One recursion step for 'count' independent lanes. dst may be x (the
+        // anti-causal pass updates rows in place), so neither is __restrict
+        static inline void iirStep(float* dst, const float* x, const float* __restrict p1,
+            const float* __restrict p2, const float* __restrict p3, int count, const RecursiveCoeffs& c) {
+            const float B = c.B, a1 = c.a1, a2 = c.a2, a3 = c.a3;
+            for (int j = 0; j < count; ++j)
+                dst[j] = B * x[j] + a1 * p1[j] + a2 * p2[j] + a3 * p3[j];
+        }
 
-                    for (int i = 0; i < n; ++i) {
-                        double val = A[i].real();
-                        val = clamp(val, 0.0, 255.0);
-                        img.at<uchar>(y, i) = static_cast<uchar>(val);
-                    }
+        // Filters 'count' lanes at once. Line element i of lane j lives at
+        // lines[i][j], so the vertical pass keeps a contiguous inner loop over x.
+        // ext/extLen describe the border: line index ext[k] is the k-th sample of the extended line, and the real
+        // samples occupy [lead, lead + n). out[i] receives real sample i.
+        static void recursiveLines(const float* const* lines, float* const* out, int n, int count,
+            const int* ext, int extLen, int lead, bool replicate, const RecursiveCoeffs& c,
+            std::vector<float>& work) {
+            // Causal results go to rows [0, extLen); the anti-causal pass overwrites
+            // them in place. Two extra rows hold the anti-causal state past the end.
+            work.resize((size_t)(extLen + 2) * count);
+            auto row = [&](int k) { return work.data() + (size_t)k * count; };
+
+            // Causal pass, started from the steady state of the first sample
+            std::memcpy(row(0), lines[ext[0]], count * sizeof(float));
+            for (int k = 1; k < extLen; ++k)
+                iirStep(row(k), lines[ext[k]], row(k - 1), row(std::max(k - 2, 0)), row(std::max(k - 3, 0)), count, c);
+
+            // Anti-causal state y[last], y[last + 1], y[last + 2]
+            const int last = extLen - 1;
+            float* s1 = row(last);
+            float* s2 = row(last + 1);
+            float* s3 = row(last + 2);
+            if (replicate && extLen >= 3) {
+                // Exact initialisation for a constant extension of the last sample
+                const float* w1 = row(last - 1);
+                const float* w2 = row(last - 2);
+                const float* u = lines[ext[last]];
+                for (int j = 0; j < count; ++j) {
+                    float d0 = s1[j] - u[j], d1 = w1[j] - u[j], d2 = w2[j] - u[j];
+                    s1[j] = c.M[0] * d0 + c.M[1] * d1 + c.M[2] * d2 + u[j];
+                    s2[j] = c.M[3] * d0 + c.M[4] * d1 + c.M[5] * d2 + u[j];
+                    s3[j] = c.M[6] * d0 + c.M[7] * d1 + c.M[8] * d2 + u[j];
                 }
             }
             else {
-                for (int x = 0; x < cols; ++x) {
-                    for (int i = 0; i < n; ++i)
-                        A[i] = static_cast<double>(img.at<uchar>(i, x));
-                    for (int i = n; i < fftSize; ++i)
-                        A[i] = 0.0;
-
-                    fft(A, false);
-                    for (int i = 0; i < fftSize; ++i)
-                        A[i] *= kernelFFT[i];
-                    fft(A, true);
-
-                    for (int i = 0; i < n; ++i) {
-                        double val = A[i].real();
-                        val = clamp(val, 0.0, 255.0);
-                        img.at<uchar>(i, x) = static_cast<uchar>(val);
-                    }
-                }
+                // The extension already absorbed the border, start from steady state
+                std::memcpy(s2, s1, count * sizeof(float));
+                std::memcpy(s3, s1, count * sizeof(float));
             }
-        }*/
-
-        static void convolve1DFFT(cv::Mat& img, const std::vector<double>& kernel, bool horizontal) {
-            int rows = img.rows;
-            int cols = img.cols;
-            int n = horizontal ? cols : rows;
-            int k = static_cast<int>(kernel.size());
-            int fftSize = nextPow2(n + k - 1);
-
-            // Precompute FFT of kernel (shared and read-only)
-            std::vector<Complex> kernelFFT(fftSize);
-            for (int i = 0; i < k; ++i)
-                kernelFFT[i] = kernel[i];
-            for (int i = k; i < fftSize; ++i)
-                kernelFFT[i] = 0.0;
-            fft(kernelFFT, false);
-
-            // Parallelized loop
-            if (horizontal) {
-#pragma omp parallel for schedule(static)
-                for (int y = 0; y < rows; ++y) {
-                    std::vector<Complex> A(fftSize);  // thread-local buffer, correctly sized
 
-                    // Copy one row
-                    for (int i = 0; i < n; ++i)
-                        A[i] = static_cast<double>(img.at<uchar>(y, i));
-                    for (int i = n; i < fftSize; ++i)
-                        A[i] = 0.0;
+            // Anti-causal pass: row k holds the causal value until it is replaced
+            for (int k = last - 1; k >= lead; --k)
+                iirStep(row(k), row(k), row(k + 1), row(k + 2), row(k + 3), count, c);
 
-                    fft(A, false);
-                    for (int i = 0; i < fftSize; ++i)
-                        A[i] *= kernelFFT[i];
-                    fft(A, true);
+            for (int i = 0; i < n; ++i)
+                std::memcpy(out[i], row(lead + i), count * sizeof(float));
+        }
 
-                    for (int i = 0; i < n; ++i) {
-                        double val = A[i].real();
-                        val = clamp(val, 0.0, 255.0);
-                        img.at<uchar>(y, i) = static_cast<uchar>(val);
+        // Runs recursiveLines down the rows of src, in column blocks across threads
+        static void recursiveBlocks(const cv::Mat& src, cv::Mat& dst, const std::vector<int>& ext, int lead,
+            bool replicate, const RecursiveCoeffs& c) {
+            const int rows = src.rows;
+            const int width = src.cols;
+            const int block = 64;
+            const int blocks = (width + block - 1) / block;
+#pragma omp parallel
+            {
+                std::vector<float> work;
+                std::vector<const float*> in(rows);
+                std::vector<float*> out(rows);
+#pragma omp for schedule(static)
+                for (int b = 0; b < blocks; ++b) {
+                    int x0 = b * block;
+                    int count = std::min(block, width - x0);
+                    for (int y = 0; y < rows; ++y) {
+                        in[y] = src.ptr<float>(y) + x0;
+                        out[y] = dst.ptr<float>(y) + x0;
                     }
+                    recursiveLines(in.data(), out.data(), rows, count, ext.data(), (int)ext.size(), lead, replicate, c, work);
                 }
             }
-            else {
-#pragma omp parallel for schedule(static)
-                for (int x = 0; x < cols; ++x) {
-                    std::vector<Complex> A(fftSize);  // thread-local buffer
-
-                    // Copy one column
-                    for (int i = 0; i < n; ++i)
-                        A[i] = static_cast<double>(img.at<uchar>(i, x));
-                    for (int i = n; i < fftSize; ++i)
-                        A[i] = 0.0;
-
-                    fft(A, false);
-                    for (int i = 0; i < fftSize; ++i)
-                        A[i] *= kernelFFT[i];
-                    fft(A, true);
+        }
 
-                    for (int i = 0; i < n; ++i) {
-                        double val = A[i].real();
-                        val = clamp(val, 0.0, 255.0);
-                        img.at<uchar>(i, x) = static_cast<uchar>(val);
+        // Transposes pixels (cn floats each) of a single-channel float image laid out as rows x (cols*cn)
+        static void transposePixels(const cv::Mat& src, cv::Mat& dst, int cn) {
+            const int rows = src.rows;
+            const int cols = src.cols / cn;
+            dst.create(cols, rows * cn, CV_32FC1);
+            const int tile = 32;
+#pragma omp parallel for schedule(static)
+            for (int ty = 0; ty < rows; ty += tile) {
+                int yEnd = std::min(ty + tile, rows);
+                for (int tx = 0; tx < cols; tx += tile) {
+                    int xEnd = std::min(tx + tile, cols);
+                    for (int y = ty; y < yEnd; ++y) {
+                        const float* s = src.ptr<float>(y);
+                        for (int x = tx; x < xEnd; ++x) {
+                            float* d = dst.ptr<float>(x) + y * cn;
+                            for (int ch = 0; ch < cn; ++ch)
+                                d[ch] = s[x * cn + ch];
+                        }
                     }
                 }
             }
         }
 
-
-        cv::Mat FFTGaussianBlur(const cv::Mat& src, double sigma) {
+        void RecursiveGaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int borderType) {
+            if (src.empty() || sigma <= 0.0) {
+                dst = src.clone();
+                return;
+            }
+            CV_Assert(src.depth() == CV_8U || src.depth() == CV_32F);
             CV_Assert(src.channels() == 1 || src.channels() == 3);
+            if (borderType != cv::BORDER_REFLECT && borderType != cv::BORDER_REFLECT_101 && borderType != cv::BORDER_WRAP)
+                borderType = cv::BORDER_REPLICATE;
 
-            int kernelRadius = std::max(1, static_cast<int>(std::ceil(3 * sigma)));
-            int kernelSize = 2 * kernelRadius + 1;
-            std::vector<double> kernel = makeGaussian1D(kernelSize, sigma);
+            const RecursiveCoeffs c = makeRecursiveCoeffs(sigma);
+            const int rows = src.rows;
+            const int cols = src.cols;
+            const int cn = src.channels();
+            const int width = cols * cn;
+
+            // Extended index tables. Replicate needs no extension at all thanks to
+            // the exact boundary initialisation (unless the line is too short).
+            auto makeExt = [&](int n, std::vector<int>& ext, int& lead) {
+                bool exact = (borderType == cv::BORDER_REPLICATE && n >= 3);
+                lead = exact ? 0 : c.pad;
+                ext.resize(n + 2 * lead);
+                for (int k = 0; k < (int)ext.size(); ++k)
+                    ext[k] = cv::borderInterpolate(k - lead, n, borderType);
+            };
+            std::vector<int> xext, yext;
+            int xlead, ylead;
+            makeExt(cols, xext, xlead);
+            makeExt(rows, yext, ylead);
+            const bool replicate = (borderType == cv::BORDER_REPLICATE);
 
-            cv::Mat result(src.size(), src.type());
+            cv::Mat srcF;
+            src.convertTo(srcF, CV_32F);
+            srcF = srcF.reshape(1);
 
-            auto processChannel = [&](const cv::Mat& channel) {
-                cv::Mat padded = reflectPad(channel, kernelRadius);
+            // Vertical pass, then the horizontal one on the pixel-transposed image.
+            // Both run the same lane kernel, which vectorizes across the lanes.
+            cv::Mat tmp(rows, width, CV_32FC1);
+            recursiveBlocks(srcF, tmp, yext, ylead, replicate, c);
 
-                convolve1DFFT(padded, kernel, true);
-                convolve1DFFT(padded, kernel, false);
+            cv::Mat tmpT, outT(cols, rows * cn, CV_32FC1);
+            transposePixels(tmp, tmpT, cn);
+            recursiveBlocks(tmpT, outT, xext, xlead, replicate, c);
 
-                cv::Rect roi(kernelRadius, kernelRadius, channel.cols, channel.rows);
-                return padded(roi).clone();
-                };
+            cv::Mat dstF;
+            transposePixels(outT, dstF, cn);
+            dstF.reshape(cn).convertTo(dst, src.type());
+        }
 
-            if (src.channels() == 1) {
-                result = processChannel(src);
-            }
-            else {
-                std::vector<cv::Mat> channels;
-                cv::split(src, channels);
-#pragma omp parallel for schedule(static)
-                for (int i = 0; i < 3; ++i)
-                    channels[i] = processChannel(channels[i]);
-                cv::merge(channels, result);
-            }
+        cv::Mat RecursiveGaussianBlur(const cv::Mat& src, double sigma, int borderType) {
+            cv::Mat dst;
+            RecursiveGaussianBlur(src, dst, sigma, borderType);
+            return dst;
+        }
 
-            return result;
+        void GaussianBlur(const cv::Mat& src, cv::Mat& dst, double sigma, int radius, int borderType, int method) {
+            switch (method) {
+            case GAUSSIAN_RECURSIVE:
+                RecursiveGaussianBlur(src, dst, sigma, borderType);
+                break;
+            case GAUSSIAN_FFT:
+                dst = FFTGaussianBlur(src, sigma, borderType);
+                break;
+            default:
+                GaussianBlur(src, dst, sigma, radius, borderType);
+                break;
+            }
         }
 	}
 }
\ No newline at end of file
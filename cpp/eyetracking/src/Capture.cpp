@@ -0,0 +1,230 @@
+#include "Capture.h"
+#include "Color.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cctype>
+
+namespace vision {
+	namespace capture {
+		static constexpr int fourccCode(char a, char b, char c, char d) {
+			return (a & 255) | ((b & 255) << 8) | ((c & 255) << 16) | ((d & 255) << 24);
+		}
+
+		size_t frameBytes(cv::Size size, YuvLayout layout) {
+			const size_t lumaBytes = (size_t)size.width * size.height;
+			switch (layout) {
+			case YuvLayout::I420:
+			case YuvLayout::NV12:
+				return lumaBytes + 2 * (size_t)((size.width + 1) / 2) * ((size.height + 1) / 2);
+			case YuvLayout::YUYV:
+			case YuvLayout::UYVY:
+				return 2 * lumaBytes;
+			default:
+				return 0;
+			}
+		}
+
+		YuvLayout parseLayout(const std::string& name) {
+			std::string s = name;
+			std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+			if (s == "i420" || s == "iyuv" || s == "yv12") return YuvLayout::I420;
+			if (s == "nv12" || s == "nv21") return YuvLayout::NV12;
+			if (s == "yuyv" || s == "yuy2") return YuvLayout::YUYV;
+			if (s == "uyvy") return YuvLayout::UYVY;
+			return YuvLayout::Auto;
+		}
+
+		// Layout from the reported fourcc, else from the buffer shape. Auto means
+		// the buffer is compressed.
+		static YuvLayout inferLayout(const cv::Mat& raw, cv::Size size, int fourcc) {
+			switch (fourcc) {
+			case fourccCode('I', '4', '2', '0'):
+			case fourccCode('I', 'Y', 'U', 'V'):
+			case fourccCode('Y', 'V', '1', '2'):
+				return YuvLayout::I420;
+			case fourccCode('N', 'V', '1', '2'):
+			case fourccCode('N', 'V', '2', '1'):
+				return YuvLayout::NV12;
+			case fourccCode('Y', 'U', 'Y', 'V'):
+			case fourccCode('Y', 'U', 'Y', '2'):
+				return YuvLayout::YUYV;
+			case fourccCode('U', 'Y', 'V', 'Y'):
+				return YuvLayout::UYVY;
+			default:
+				break;
+			}
+			if (raw.type() == CV_8UC2)
+				return YuvLayout::YUYV;
+			const size_t bytes = raw.total() * raw.elemSize();
+			if (bytes == frameBytes(size, YuvLayout::I420))
+				return YuvLayout::I420;
+			if (bytes == frameBytes(size, YuvLayout::YUYV))
+				return YuvLayout::YUYV;
+			return YuvLayout::Auto;
+		}
+
+		// Keeps byte offset (0 for YUYV, 1 for UYVY) of every pixel pair
+		static void lumaRowPacked(const uchar* src, uchar* dst, int width, int offset) {
+			int x = 0;
+#if defined(VISION_SIMD_SSE2)
+			const __m128i mask = _mm_set1_epi16(0x00FF);
+			for (; x <= width - 16; x += 16) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * x));
+				__m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * x + 16));
+				if (offset) {
+					a = _mm_srli_epi16(a, 8);
+					b = _mm_srli_epi16(b, 8);
+				}
+				else {
+					a = _mm_and_si128(a, mask);
+					b = _mm_and_si128(b, mask);
+				}
+				_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(a, b));
+			}
+#endif
+			for (; x < width; ++x)
+				dst[x] = src[2 * x + offset];
+		}
+
+		void extractLuma(const cv::Mat& raw, cv::Mat& luma, cv::Size frameSize, YuvLayout layout, int fourcc) {
+			CV_Assert(!raw.empty() && raw.depth() == CV_8U);
+
+			if (raw.channels() == 3) {
+				vision::color::BGR2Gray(raw, luma);
+				return;
+			}
+			if (frameSize.area() <= 0)
+				frameSize = raw.size();
+			if (raw.channels() == 1 && raw.size() == frameSize) {
+				// already a gray frame
+				luma = raw;
+				return;
+			}
+
+			if (layout == YuvLayout::Auto)
+				layout = inferLayout(raw, frameSize, fourcc);
+
+			const int w = frameSize.width, h = frameSize.height;
+			switch (layout) {
+			case YuvLayout::I420:
+			case YuvLayout::NV12:
+				// Y is the leading w x h block of the buffer
+				if (raw.channels() == 1 && raw.cols == w && raw.rows >= h) {
+					luma = raw.rowRange(0, h);
+				}
+				else {
+					CV_Assert(raw.isContinuous() && raw.total() * raw.elemSize() >= (size_t)w * h);
+					luma = raw.reshape(1, 1).colRange(0, w * h).reshape(1, h);
+				}
+				return;
+			case YuvLayout::YUYV:
+			case YuvLayout::UYVY: {
+				const int offset = layout == YuvLayout::UYVY ? 1 : 0;
+				const bool rowed = raw.channels() == 2 && raw.cols == w && raw.rows == h;
+				CV_Assert(rowed || (raw.isContinuous() && raw.total() * raw.elemSize() >= 2 * (size_t)w * h));
+				luma.create(h, w, CV_8UC1);
+				for (int y = 0; y < h; ++y) {
+					const uchar* src = rowed ? raw.ptr<uchar>(y) : raw.data + 2 * (size_t)w * y;
+					lumaRowPacked(src, luma.ptr<uchar>(y), w, offset);
+				}
+				return;
+			}
+			default:
+				// Compressed (MJPEG): a grayscale decode only converts the Y component
+				luma = cv::imdecode(raw.reshape(1, 1), cv::IMREAD_GRAYSCALE);
+				CV_Assert(!luma.empty());
+				return;
+			}
+		}
+
+		void LumaCapture::configureRaw() {
+			rawMode = cap.set(cv::CAP_PROP_CONVERT_RGB, 0);
+			// V4L2 only hands out the driver buffer with CAP_PROP_FORMAT = -1
+			if (cap.getBackendName() == "V4L2")
+				cap.set(cv::CAP_PROP_FORMAT, -1);
+			fourcc = static_cast<int>(cap.get(cv::CAP_PROP_FOURCC));
+			size = cv::Size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)),
+				static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+			layout = YuvLayout::Auto;
+		}
+
+		bool LumaCapture::open(int camIndex, int width, int height) {
+			release();
+			if (!cap.open(camIndex))
+				return false;
+			if (width > 0 && height > 0) {
+				cap.set(cv::CAP_PROP_FRAME_WIDTH, width);
+				cap.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+			}
+			configureRaw();
+			return true;
+		}
+
+		bool LumaCapture::open(const std::string& link) {
+			release();
+			if (!cap.open(link))
+				return false;
+			configureRaw();
+			return true;
+		}
+
+		bool LumaCapture::openRawFile(const std::string& path, cv::Size frameSize, YuvLayout fileLayout) {
+			CV_Assert(fileLayout != YuvLayout::Auto && frameSize.area() > 0);
+			release();
+			file.open(path, std::ios::binary);
+			if (!file.is_open())
+				return false;
+			fromFile = true;
+			rawMode = true;
+			size = frameSize;
+			layout = fileLayout;
+			return true;
+		}
+
+		bool LumaCapture::isOpened() const {
+			return fromFile ? file.is_open() : cap.isOpened();
+		}
+
+		void LumaCapture::release() {
+			cap.release();
+			if (file.is_open())
+				file.close();
+			file.clear();
+			fromFile = false;
+			rawMode = false;
+			grabbed = false;
+			fourcc = 0;
+		}
+
+		bool LumaCapture::grab() {
+			if (!fromFile) {
+				grabbed = cap.grab();
+				return grabbed;
+			}
+
+			const size_t total = frameBytes(size, layout);
+			const bool planar = layout == YuvLayout::I420 || layout == YuvLayout::NV12;
+			// Planar frames only read the Y plane and seek over the chroma
+			const size_t wanted = planar ? (size_t)size.area() : total;
+			raw.create(1, static_cast<int>(wanted), CV_8UC1);
+			grabbed = static_cast<bool>(file.read(reinterpret_cast<char*>(raw.data), wanted));
+			if (grabbed && planar)
+				file.seekg(static_cast<std::streamoff>(total - wanted), std::ios::cur);
+			return grabbed;
+		}
+
+		bool LumaCapture::retrieve(cv::Mat& luma) {
+			if (!grabbed)
+				return false;
+			grabbed = false;
+			if (!fromFile) {
+				if (!cap.retrieve(raw) || raw.empty())
+					return false;
+				if (raw.channels() == 3)
+					rawMode = false;
+			}
+			extractLuma(raw, luma, size, layout, fourcc);
+			return !luma.empty();
+		}
+	}
+}
@@ -1,8 +1,111 @@
 #include "Color.h"
 #include "Utils.h"
+#include "Simd.h"
+#include <cstdint>
+#include <vector>
 
 namespace vision {
     namespace color {
+        // ------------------------------------------------------------------
+        // Q14 luma weights (sum 16384), the same ones cv::cvtColor uses:
+        // gray = (1868 * B + 9617 * G + 4899 * R + 8192) >> 14
+        // ------------------------------------------------------------------
+        static const int kShift = 14;
+        static const int kCoefB = 1868;
+        static const int kCoefG = 9617;
+        static const int kCoefR = 4899;
+
+        // Rows are only split across threads above this many pixels
+        static const int kParallelMinPixels = 320 * 240;
+
+#if defined(VISION_SIMD_SSSE3)
+        // Splits 16 interleaved BGR pixels (48 bytes) into B, G and R vectors
+        static inline void deinterleaveBGR(const uchar* p, __m128i& b, __m128i& g, __m128i& r) {
+            const __m128i v0 = _mm_loadu_si128((const __m128i*)p);
+            const __m128i v1 = _mm_loadu_si128((const __m128i*)(p + 16));
+            const __m128i v2 = _mm_loadu_si128((const __m128i*)(p + 32));
+            b = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(v0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+            g = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(v0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+            r = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(v0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+        }
+
+        // Weighted sums of 8 pixels (16-bit B, G, R lanes) as two int32 vectors, rounding term included.
+        // (B, G) pairs go through one madd and (R, 1) pairs through another.
+        static inline void lumaSums(__m128i b16, __m128i g16, __m128i r16, __m128i roundTerm, __m128i& lo, __m128i& hi) {
+            const __m128i wbg = _mm_setr_epi16(kCoefB, kCoefG, kCoefB, kCoefG, kCoefB, kCoefG, kCoefB, kCoefG);
+            const __m128i wr1 = _mm_setr_epi16(kCoefR, 1, kCoefR, 1, kCoefR, 1, kCoefR, 1);
+            __m128i r1lo = _mm_unpacklo_epi16(r16, roundTerm), r1hi = _mm_unpackhi_epi16(r16, roundTerm);
+            lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), wbg), _mm_madd_epi16(r1lo, wr1));
+            hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), wbg), _mm_madd_epi16(r1hi, wr1));
+        }
+#endif
+
+        // One BGR row to 8-bit gray
+        static void grayRow8u(const uchar* src, uchar* dst, int width) {
+            int x = 0;
+#if defined(VISION_SIMD_SSSE3)
+            const __m128i zero = _mm_setzero_si128();
+            // the rounding term rides along as the second operand of the R madd
+            const __m128i roundTerm = _mm_set1_epi16(1 << (kShift - 1));
+            for (; x <= width - 16; x += 16) {
+                __m128i b, g, r;
+                deinterleaveBGR(src + 3 * x, b, g, r);
+                __m128i lo0, hi0, lo1, hi1;
+                lumaSums(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(r, zero), roundTerm, lo0, hi0);
+                lumaSums(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero), roundTerm, lo1, hi1);
+                __m128i p0 = _mm_packs_epi32(_mm_srli_epi32(lo0, kShift), _mm_srli_epi32(hi0, kShift));
+                __m128i p1 = _mm_packs_epi32(_mm_srli_epi32(lo1, kShift), _mm_srli_epi32(hi1, kShift));
+                _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(p0, p1));
+            }
+#endif
+            for (; x < width; ++x) {
+                const uchar* p = src + 3 * x;
+                dst[x] = static_cast<uchar>((kCoefB * p[0] + kCoefG * p[1] + kCoefR * p[2] + (1 << (kShift - 1))) >> kShift);
+            }
+        }
+
+        // One BGR row to gray with 6 fractional bits (<= 255 * 64), added onto acc
+        // when accumulate is set. Used by the decimating conversion.
+        static const int kFracBits = 6;
+        static void grayRow16u(const uchar* src, uint16_t* acc, int width, bool accumulate) {
+            const int shift = kShift - kFracBits;
+            int x = 0;
+#if defined(VISION_SIMD_SSSE3)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i roundTerm = _mm_set1_epi16(1 << (shift - 1));
+            for (; x <= width - 16; x += 16) {
+                __m128i b, g, r;
+                deinterleaveBGR(src + 3 * x, b, g, r);
+                __m128i lo0, hi0, lo1, hi1;
+                lumaSums(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(r, zero), roundTerm, lo0, hi0);
+                lumaSums(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero), roundTerm, lo1, hi1);
+                // values fit 14 bits, so the signed pack is safe
+                __m128i p0 = _mm_packs_epi32(_mm_srli_epi32(lo0, shift), _mm_srli_epi32(hi0, shift));
+                __m128i p1 = _mm_packs_epi32(_mm_srli_epi32(lo1, shift), _mm_srli_epi32(hi1, shift));
+                if (accumulate) {
+                    p0 = _mm_add_epi16(p0, _mm_loadu_si128((const __m128i*)(acc + x)));
+                    p1 = _mm_add_epi16(p1, _mm_loadu_si128((const __m128i*)(acc + x + 8)));
+                }
+                _mm_storeu_si128((__m128i*)(acc + x), p0);
+                _mm_storeu_si128((__m128i*)(acc + x + 8), p1);
+            }
+#endif
+            for (; x < width; ++x) {
+                const uchar* p = src + 3 * x;
+                int v = (kCoefB * p[0] + kCoefG * p[1] + kCoefR * p[2] + (1 << (shift - 1))) >> shift;
+                acc[x] = static_cast<uint16_t>(accumulate ? acc[x] + v : v);
+            }
+        }
+
         void BGR2Gray(const cv::Mat& src, cv::Mat& dst)
         {
             if (src.empty() || src.channels() != 3)
@@ -12,26 +115,84 @@ namespace vision {
 
             dst.create(src.rows, src.cols, CV_8UC1);
 
-            for (int y = 0; y < src.rows; ++y)
+            const int rows = src.rows;
+            const int cols = src.cols;
+#pragma omp parallel for schedule(static) if (rows * cols >= kParallelMinPixels)
+            for (int y = 0; y < rows; ++y)
+                grayRow8u(src.ptr<uchar>(y), dst.ptr<uchar>(y), cols);
+        }
+
+        cv::Mat BGR2Gray(const cv::Mat& src)
+        {
+            cv::Mat dst;
+            BGR2Gray(src, dst);
+            return dst;
+		}
+
+        void BGR2GrayDecimate(const cv::Mat& src, cv::Mat& dst, int factor)
+        {
+            if (src.empty() || src.channels() != 3)
+            {
+                throw std::invalid_argument("Input image must be a non-empty 3-channel BGR image.");
+            }
+            if (factor != 1 && factor != 2 && factor != 4)
             {
-                const uchar* srcRow = src.ptr<uchar>(y);
-                uchar* dstRow = dst.ptr<uchar>(y);
+                throw std::invalid_argument("Decimation factor must be 1, 2 or 4.");
+            }
+            if (factor == 1)
+            {
+                BGR2Gray(src, dst);
+                return;
+            }
 
-                for (int x = 0; x < src.cols; ++x)
-                {
-                    uchar B = srcRow[x * 3 + 0];
-                    uchar G = srcRow[x * 3 + 1];
-                    uchar R = srcRow[x * 3 + 2];
+            const int rows = src.rows / factor;
+            const int cols = src.cols / factor;
+            const int srcCols = cols * factor;
+            // K x K sums of 6-bit fraction gray values, rounded once
+            const int shift = kFracBits + (factor == 2 ? 2 : 4);
+            const int delta = 1 << (shift - 1);
+            dst.create(rows, cols, CV_8UC1);
 
-                    dstRow[x] = static_cast<uchar>(0.114 * B + 0.587 * G + 0.299 * R);
+#pragma omp parallel if (rows * cols * factor * factor >= kParallelMinPixels)
+            {
+                std::vector<uint16_t> acc(srcCols);
+#pragma omp for schedule(static)
+                for (int y = 0; y < rows; ++y) {
+                    for (int k = 0; k < factor; ++k)
+                        grayRow16u(src.ptr<uchar>(y * factor + k), acc.data(), srcCols, k > 0);
+                    uchar* d = dst.ptr<uchar>(y);
+                    const uint16_t* a = acc.data();
+                    if (factor == 2) {
+                        int x = 0;
+#if defined(VISION_SIMD_SSE2)
+                        // pair sums stay below 2^15, so madd with ones is exact
+                        const __m128i ones = _mm_set1_epi16(1);
+                        const __m128i d128 = _mm_set1_epi32(delta);
+                        for (; x <= cols - 8; x += 8) {
+                            __m128i lo = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + 2 * x)), ones);
+                            __m128i hi = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + 2 * x + 8)), ones);
+                            lo = _mm_srli_epi32(_mm_add_epi32(lo, d128), shift);
+                            hi = _mm_srli_epi32(_mm_add_epi32(hi, d128), shift);
+                            __m128i p = _mm_packs_epi32(lo, hi);
+                            _mm_storel_epi64((__m128i*)(d + x), _mm_packus_epi16(p, p));
+                        }
+#endif
+                        for (; x < cols; ++x)
+                            d[x] = static_cast<uchar>((a[2 * x] + a[2 * x + 1] + delta) >> shift);
+                    }
+                    else {
+                        for (int x = 0; x < cols; ++x)
+                            d[x] = static_cast<uchar>((a[4 * x] + a[4 * x + 1] + a[4 * x + 2] + a[4 * x + 3] + delta) >> shift);
+                    }
                 }
             }
         }
-        cv::Mat BGR2Gray(const cv::Mat& src)
+
+        cv::Mat BGR2GrayDecimate(const cv::Mat& src, int factor)
         {
             cv::Mat dst;
-            BGR2Gray(src, dst);
+            BGR2GrayDecimate(src, dst, factor);
             return dst;
-		}
+        }
     }
 }
@@ -0,0 +1,63 @@
+#include "DebugSink.h"
+
+namespace vision {
+	namespace debug {
+		AsyncDebugSink::~AsyncDebugSink() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			cond.notify_all();
+			if (worker.joinable())
+				worker.join();
+		}
+
+		void AsyncDebugSink::setSink(Sink s) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				sink = std::move(s);
+				hasSink = static_cast<bool>(sink);
+				if (!sink) {
+					hasJob = false;
+					job = nullptr;
+				}
+			}
+			// Worker is started lazily so detectors without a sink never spawn a thread
+			if (enabled() && !worker.joinable())
+				worker = std::thread(&AsyncDebugSink::workerLoop, this);
+		}
+
+		void AsyncDebugSink::post(const std::string& name, std::function<cv::Mat()> render) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!sink) return;
+				jobName = name;
+				job = std::move(render);
+				hasJob = true;
+			}
+			cond.notify_one();
+		}
+
+		void AsyncDebugSink::workerLoop() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				cond.wait(lock, [this] { return stop || hasJob; });
+				if (stop) break;
+
+				std::string name = jobName;
+				std::function<cv::Mat()> render = std::move(job);
+				Sink target = sink;
+				hasJob = false;
+				job = nullptr;
+
+				lock.unlock();
+				if (render && target) {
+					cv::Mat image = render();
+					if (!image.empty())
+						target(name, image);
+				}
+				lock.lock();
+			}
+		}
+	}
+}
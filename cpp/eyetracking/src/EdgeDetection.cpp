@@ -1,101 +1,355 @@
 #include "EdgeDetection.h"
 #include "Utils.h"
+#include "Simd.h"
+#include <opencv2/core/hal/hal.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 
 namespace vision {
 	namespace canny {
-		cv::Mat canny(const cv::Mat& in, bool blurImage, bool useL2, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio) {
-			CV_Assert(!in.empty());
-			CV_Assert(in.channels() == 1);
+		// Rows are only split across threads above this many pixels
+		static const int kParallelMinPixels = 320 * 240;
 
-			cv::Size workingSize;
-			workingSize.width = in.cols;
-			workingSize.height = in.rows;
+		// Integer-mode helpers. On 8-bit input the Sobel responses stay below 2^14
+		// (255 * 3 * 16 for 5x5, 255 * 10 * 64 / 16 for the scaled 7x7), so |dx|, |dy|,
+		// L1 and L2 magnitudes all fit a signed 16-bit lane.
+		static const int kMaxMagnitude = 32767;
+		static const int kTan22_5 = 13573; // tan(22.5 deg) in Q15
+		static const double kSobel7Scale = 1.0 / 16;
 
-			cv::Mat dx= cv::Mat::zeros(workingSize, CV_32F), dy = cv::Mat::zeros(workingSize, CV_32F), magnitude = cv::Mat::zeros(workingSize, CV_32F);
-			cv::Mat edgeType = cv::Mat::zeros(workingSize, CV_8U), edge = cv::Mat::zeros(workingSize, CV_8U);
+		enum Direction : uchar {
+			DirHorizontal = 0, // compare left / right
+			DirVertical = 1,   // compare top / bottom
+			DirDiagonal = 2,   // dx and dy share a sign: top-left / bottom-right
+			DirAntiDiagonal = 3
+		};
 
-			//(void)useL2; // Unused parameter, Sebenernya buat implement norm aja
-			/* Step 1: Smoothing & Directional Gradients  */
+		static inline uchar directionOf(int ix, int iy) {
+			const int x = std::abs(ix), y = std::abs(iy);
+			if ((y << 15) < x * kTan22_5)
+				return DirHorizontal;
+			if (y * kTan22_5 > (x << 15))
+				return DirVertical;
+			return (iy > 0) == (ix > 0) ? DirDiagonal : DirAntiDiagonal;
+		}
 
-			cv::Mat blurred;
-			if (blurImage) {
-				cv::Size blurSize(5, 5);
-				cv::GaussianBlur(in, blurred, blurSize, 1.5, 1.5, cv::BORDER_REPLICATE);
-			}
-			else blurred = in;
+		// Magnitude and direction of one row; returns the row maximum
+		static int magnitudeRow(const short* dxRow, const short* dyRow, ushort* magRow, uchar* dirRow, int width, bool useL2) {
+			int j = 0;
+			int rowMax = 0;
+#if defined(VISION_SIMD_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i one = _mm_set1_epi16(1);
+			const __m128i two = _mm_set1_epi16(2);
+			const __m128i tanWeights = _mm_setr_epi16(kTan22_5, -16384, kTan22_5, -16384, kTan22_5, -16384, kTan22_5, -16384);
+			__m128i vmax = zero;
+			for (; j <= width - 8; j += 8) {
+				const __m128i ix = _mm_loadu_si128((const __m128i*)(dxRow + j));
+				const __m128i iy = _mm_loadu_si128((const __m128i*)(dyRow + j));
+				const __m128i x = _mm_max_epi16(ix, _mm_sub_epi16(zero, ix));
+				const __m128i y = _mm_max_epi16(iy, _mm_sub_epi16(zero, iy));
 
-			const int sobel_ksize = 7;
-			cv::Sobel(blurred, dx, dx.type(), 1, 0, sobel_ksize, 1, 0, cv::BORDER_REPLICATE); // ksize = 3 di sourcenya
-			cv::Sobel(blurred, dy, dy.type(), 0, 1, sobel_ksize, 1, 0, cv::BORDER_REPLICATE); // ksize = 7 di sourcenya
+				__m128i m;
+				if (useL2) {
+					// x * x + y * y straight from madd of the interleaved pair, then a rounded float sqrt
+					const __m128i lo = _mm_unpacklo_epi16(x, y), hi = _mm_unpackhi_epi16(x, y);
+					const __m128i a = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo))));
+					const __m128i b = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi))));
+					m = _mm_packs_epi32(a, b);
+				}
+				else {
+					m = _mm_add_epi16(x, y);
+				}
+				_mm_storeu_si128((__m128i*)(magRow + j), m);
+				vmax = _mm_max_epi16(vmax, m);
 
-			/* Magnitude */
-			double minMag = 0;
-			double maxMag = 0;
-			float* p_res;
-			float* p_x, * p_y; // result, x, y
+				// (y << 15) < x * tan  <=>  x * tan - 2y * 16384 > 0, same for the 67.5 deg test
+				const __m128i y2 = _mm_add_epi16(y, y), x2 = _mm_add_epi16(x, x);
+				const __m128i horiz = _mm_packs_epi32(
+					_mm_cmpgt_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, y2), tanWeights), zero),
+					_mm_cmpgt_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, y2), tanWeights), zero));
+				const __m128i vert = _mm_packs_epi32(
+					_mm_cmpgt_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, x2), tanWeights), zero),
+					_mm_cmpgt_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, x2), tanWeights), zero));
+				const __m128i opposite = _mm_xor_si128(_mm_cmpgt_epi16(ix, zero), _mm_cmpgt_epi16(iy, zero));
+				__m128i d = _mm_add_epi16(two, _mm_and_si128(opposite, one));
+				d = _mm_or_si128(_mm_andnot_si128(vert, d), _mm_and_si128(vert, one));
+				d = _mm_andnot_si128(horiz, d);
+				_mm_storel_epi64((__m128i*)(dirRow + j), _mm_packus_epi16(d, d));
+			}
+			vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+			vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+			vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+			rowMax = _mm_cvtsi128_si32(vmax) & 0xFFFF;
+#endif
+			for (; j < width; j++) {
+				const int x = std::abs((int)dxRow[j]), y = std::abs((int)dyRow[j]);
+				int m;
+				if (useL2)
+					m = cvRound(std::sqrt(static_cast<float>(x * x + y * y)));
+				else
+					m = x + y;
+				magRow[j] = static_cast<ushort>(m);
+				rowMax = std::max(rowMax, m);
+				dirRow[j] = directionOf(dxRow[j], dyRow[j]);
+			}
+			return rowMax;
+		}
 
-			// magnitude (L2)
-			if (useL2) {
-				cv::magnitude(dx, dy, magnitude);
+		void CannyEngine::prepare(cv::Size workingSize, int bins) {
+			if (workingSize != size) {
+				size = workingSize;
+				traceStack.resize((size_t)size.area());
+			}
+			bands = size.area() >= kParallelMinPixels ? std::max(1, std::min(omp_get_max_threads(), size.height)) : 1;
+			// create() is a no-op once the buffers match, so switching modes only
+			// allocates on the first frame in the new mode
+			if (!isIntegerMode()) {
+				dx.create(size, CV_32F);
+				dy.create(size, CV_32F);
+				magnitude.create(size, CV_32F);
 			}
 			else {
-				// L1 approx: |dx| + |dy|
-				cv::Mat absx, absy;
-				cv::absdiff(dx, cv::Scalar(0), absx);
-				cv::absdiff(dy, cv::Scalar(0), absy);
-				magnitude = absx + absy;
-			}
-
-			/* Normalization */
-			cv::minMaxLoc(magnitude, &minMag, &maxMag);
-			magnitude = magnitude / maxMag;
-
-			/* Step 2: Threshold Selection (Based on Magnitude Historgram */
-			float low_th = 0;
-			float high_th = 0;
-
-			int* histogram = new int[bins]();
-			cv::Mat res_idx = (bins - 1) * magnitude; //value range [0,bins-1]
-			res_idx.convertTo(res_idx, CV_16U);
-			short* p_res_idx = 0;
-			for (int i = 0; i < res_idx.rows; i++)
-			{
-				p_res_idx = res_idx.ptr<short>(i);
-				for (int j = 0; j < res_idx.cols; j++)
-					histogram[p_res_idx[j]]++;
+				dx16.create(size, CV_16S);
+				dy16.create(size, CV_16S);
+				magnitude16.create(size, CV_16U);
+				direction.create(size, CV_8U);
+				bandCounts.resize((size_t)bands * (kMaxMagnitude + 1));
 			}
+			edgeType.create(size, CV_8U);
+			edge.create(size, CV_8U);
+			histogram.assign(bins, 0);
+			bandHistograms.assign((size_t)bands * bins, 0);
+			bandMax.resize(bands);
+			bandSpilled.resize(bands);
+			if (collectPixels)
+				bandPixels.resize(bands);
+			// a band only spills from its first and last row, three neighbours per pixel
+			spillBuffer.resize(bands > 1 ? (size_t)bands * 6 * size.width : 0);
+		}
 
+		// High threshold: upper edge of the first bin where the cumulative count
+		// passes nonEdgePixelsRatio of the image. Both are in normalized [0, 1] units.
+		static void pickThresholds(const std::vector<int>& hist, int pixels, float nonEdgePixelsRatio, float lowHighThresholdRatio, float& lowTh, float& highTh) {
+			const int bins = static_cast<int>(hist.size());
+			lowTh = 0;
+			highTh = 0;
 			int sum = 0;
-			int nonEdgePixels = nonEdgePixelsRatio * in.rows * in.cols;
+			int nonEdgePixels = nonEdgePixelsRatio * pixels;
 			for (int i = 0; i < bins; i++)
 			{
-				sum += histogram[i];
+				sum += hist[i];
 				if (sum > nonEdgePixels)
 				{
-					high_th = float(i + 1) / bins;
+					highTh = float(i + 1) / bins;
 					break;
 				}
 			}
-			low_th = lowHighThresholdRatio * high_th;
+			lowTh = lowHighThresholdRatio * highTh;
+		}
+
+		// Derivative-of-Gaussian helpers. Kernels are stored as half taps 0..r;
+		// the smoothing tap k applies to both sides, the derivative tap k with a
+		// minus sign on the leading side.
+
+		// Vertical sweep of row y: sm = G * I and dv = G' * I, reading each pair of
+		// rows once for both
+		static void dogColumns(const cv::Mat& in, int y, const float* g, const float* gd, int r, float* sm, float* dv) {
+			const int cols = in.cols, last = in.rows - 1;
+			const uchar* center = in.ptr<uchar>(y);
+			for (int x = 0; x < cols; x++) {
+				sm[x] = g[0] * center[x];
+				dv[x] = 0;
+			}
+			for (int k = 1; k <= r; k++) {
+				const uchar* up = in.ptr<uchar>(std::max(y - k, 0));
+				const uchar* dn = in.ptr<uchar>(std::min(y + k, last));
+				const float gk = g[k], gdk = gd[k];
+				int x = 0;
+#if defined(VISION_SIMD_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				const __m128 vg = _mm_set1_ps(gk), vgd = _mm_set1_ps(gdk);
+				for (; x <= cols - 8; x += 8) {
+					const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(up + x)), zero);
+					const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(dn + x)), zero);
+					const __m128i sum = _mm_add_epi16(u, v), diff = _mm_sub_epi16(v, u);
+					const __m128 sumLo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero));
+					const __m128 sumHi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(sum, zero));
+					const __m128 diffLo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(diff, diff), 16));
+					const __m128 diffHi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(diff, diff), 16));
+					_mm_storeu_ps(sm + x, _mm_add_ps(_mm_loadu_ps(sm + x), _mm_mul_ps(vg, sumLo)));
+					_mm_storeu_ps(sm + x + 4, _mm_add_ps(_mm_loadu_ps(sm + x + 4), _mm_mul_ps(vg, sumHi)));
+					_mm_storeu_ps(dv + x, _mm_add_ps(_mm_loadu_ps(dv + x), _mm_mul_ps(vgd, diffLo)));
+					_mm_storeu_ps(dv + x + 4, _mm_add_ps(_mm_loadu_ps(dv + x + 4), _mm_mul_ps(vgd, diffHi)));
+				}
+#endif
+				for (; x < cols; x++) {
+					sm[x] += gk * (float)(up[x] + dn[x]);
+					dv[x] += gdk * (float)(dn[x] - up[x]);
+				}
+			}
+		}
+
+		// Horizontal sweep: dx = G' * sm and dy = G * dv. Both rows carry r
+		// replicated pixels on each side.
+		static void dogRow(const float* sm, const float* dv, const float* g, const float* gd, int r, float* dxRow, float* dyRow, int cols) {
+			int x = 0;
+#if defined(VISION_SIMD_SSE2)
+			const __m128 g0 = _mm_set1_ps(g[0]);
+			for (; x <= cols - 4; x += 4) {
+				__m128 sx = _mm_setzero_ps();
+				__m128 sy = _mm_mul_ps(g0, _mm_loadu_ps(dv + x));
+				for (int k = 1; k <= r; k++) {
+					const __m128 d = _mm_sub_ps(_mm_loadu_ps(sm + x + k), _mm_loadu_ps(sm + x - k));
+					const __m128 s = _mm_add_ps(_mm_loadu_ps(dv + x + k), _mm_loadu_ps(dv + x - k));
+					sx = _mm_add_ps(sx, _mm_mul_ps(_mm_set1_ps(gd[k]), d));
+					sy = _mm_add_ps(sy, _mm_mul_ps(_mm_set1_ps(g[k]), s));
+				}
+				_mm_storeu_ps(dxRow + x, sx);
+				_mm_storeu_ps(dyRow + x, sy);
+			}
+#endif
+			for (; x < cols; x++) {
+				float sx = 0;
+				float sy = g[0] * dv[x];
+				for (int k = 1; k <= r; k++) {
+					sx += gd[k] * (sm[x + k] - sm[x - k]);
+					sy += g[k] * (dv[x + k] + dv[x - k]);
+				}
+				dxRow[x] = sx;
+				dyRow[x] = sy;
+			}
+		}
+
+		void CannyEngine::derivativeOfGaussian(const cv::Mat& in) {
+			CV_Assert(in.depth() == CV_8U);
+			if (dogKernelSigma != dogSigma) {
+				// Unit-sum Gaussian; derivative scaled to a unit response on a ramp
+				const int radius = std::max(1, cvCeil(3 * dogSigma));
+				dogSmooth.assign(radius + 1, 0.f);
+				dogDerivative.assign(radius + 1, 0.f);
+				double sum = 0, moment = 0;
+				std::vector<double> w(radius + 1);
+				for (int k = 0; k <= radius; k++) {
+					w[k] = std::exp(-0.5 * k * k / ((double)dogSigma * dogSigma));
+					sum += k == 0 ? w[k] : 2 * w[k];
+					moment += 2.0 * k * k * w[k];
+				}
+				for (int k = 0; k <= radius; k++) {
+					dogSmooth[k] = static_cast<float>(w[k] / sum);
+					dogDerivative[k] = static_cast<float>(k * w[k] / moment);
+				}
+				dogKernelSigma = dogSigma;
+			}
+
+			const int r = static_cast<int>(dogSmooth.size()) - 1;
+			const int rows = size.height, cols = size.width;
+			const float* g = dogSmooth.data();
+			const float* gd = dogDerivative.data();
+			dogRows.create(2 * omp_get_max_threads(), cols + 2 * r, CV_32F);
+
+#pragma omp parallel if (rows * cols >= kParallelMinPixels)
+			{
+				const int t = omp_get_thread_num();
+				float* sm = dogRows.ptr<float>(2 * t) + r;
+				float* dv = dogRows.ptr<float>(2 * t + 1) + r;
+#pragma omp for schedule(static)
+				for (int y = 0; y < rows; y++) {
+					dogColumns(in, y, g, gd, r, sm, dv);
+					for (int k = 1; k <= r; k++) {
+						sm[-k] = sm[0];
+						dv[-k] = dv[0];
+						sm[cols - 1 + k] = sm[cols - 1];
+						dv[cols - 1 + k] = dv[cols - 1];
+					}
+					dogRow(sm, dv, g, gd, r, dx.ptr<float>(y), dy.ptr<float>(y), cols);
+				}
+			}
+		}
+
+		/* Step 1: Smoothing & Directional Gradients */
+		void CannyEngine::derivatives(const cv::Mat& in, bool blurImage) {
+			if (gradientMode == GradientMode::DerivativeOfGaussian) {
+				derivativeOfGaussian(in);
+				return;
+			}
+
+			const cv::Mat* src = &in;
+			if (blurImage) {
+				cv::Size blurSize(5, 5);
+				cv::GaussianBlur(in, blurred, blurSize, 1.5, 1.5, cv::BORDER_REPLICATE);
+				src = &blurred;
+			}
+
+			const int sobel_ksize = 7;
+			cv::Sobel(*src, dx, dx.type(), 1, 0, sobel_ksize, 1, 0, cv::BORDER_REPLICATE); // ksize = 3 di sourcenya
+			cv::Sobel(*src, dy, dy.type(), 0, 1, sobel_ksize, 1, 0, cv::BORDER_REPLICATE); // ksize = 7 di sourcenya
+		}
+
+		// Magnitude of rows [rowBegin, rowEnd); returns their maximum
+		float CannyEngine::magnitudeBand(int rowBegin, int rowEnd, bool useL2) {
+			const int cols = size.width;
+			float maxMag = 0;
+			for (int i = rowBegin; i < rowEnd; i++) {
+				const float* p_x = dx.ptr<float>(i);
+				const float* p_y = dy.ptr<float>(i);
+				float* p_res = magnitude.ptr<float>(i);
+				if (useL2) {
+					cv::hal::magnitude32f(p_x, p_y, p_res, cols);
+				}
+				else {
+					// L1 approx: |dx| + |dy|
+					for (int j = 0; j < cols; j++)
+						p_res[j] = std::abs(p_x[j]) + std::abs(p_y[j]);
+				}
+				for (int j = 0; j < cols; j++)
+					maxMag = std::max(maxMag, p_res[j]);
+			}
+			return maxMag;
+		}
+
+		// Normalizes rows [rowBegin, rowEnd) to [0, 1] in place (same scaling as
+		// magnitude / maxMag) and counts them into hist
+		void CannyEngine::normalizeBand(int rowBegin, int rowEnd, float maxMag, int* hist, int bins) {
+			// bin index = round((bins - 1) * magnitude), value range [0, bins - 1]
+			const float scale = static_cast<float>(1.0 / maxMag);
+			const float binScale = static_cast<float>(bins - 1);
+			for (int i = rowBegin; i < rowEnd; i++) {
+				float* p_res = magnitude.ptr<float>(i);
+				for (int j = 0; j < size.width; j++) {
+					p_res[j] *= scale;
+					hist[cvRound(p_res[j] * binScale)]++;
+				}
+			}
+		}
 
-			/* Step 3: Non-Maximum Suppression, Thin out fat gradient edges into 1-pixel-wide edges */
+		/* Step 2: Threshold Selection (Based on Magnitude Histogram) */
+		void CannyEngine::thresholds(int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio, float& lowTh, float& highTh) {
+			for (int b = 0; b < bands; b++)
+				for (int i = 0; i < bins; i++)
+					histogram[i] += bandHistograms[(size_t)b * bins + i];
+
+			pickThresholds(histogram, size.area(), nonEdgePixelsRatio, lowHighThresholdRatio, lowTh, highTh);
+		}
+
+		/* Step 3: Non-Maximum Suppression, thin out "fat" gradient edges into 1-pixel-wide edges */
+		// Writes edgeType rows [rowBegin, rowEnd), reading magnitude one row beyond
+		void CannyEngine::nonMaximumSuppression(int rowBegin, int rowEnd, float low_th, float high_th) {
 			const float tg22_5 = 0.4142135623730950488016887242097f; // tan(22.5 derajat)
 			const float tg67_5 = 2.4142135623730950488016887242097f; // tan(67.5 derajat)
-			uchar* _edgeType;
-			float* p_res_b, * p_res_t;
-			edgeType.setTo(0);
-			for (int i = 1; i < magnitude.rows - 1; i++)
+			std::memset(edgeType.ptr<uchar>(rowBegin), 0, (size_t)(rowEnd - rowBegin) * size.width);
+			for (int i = std::max(rowBegin, 1); i < std::min(rowEnd, magnitude.rows - 1); i++)
 			{
-				_edgeType = edgeType.ptr<uchar>(i); // Gives _edgeType to point to the beginning of row i
+				uchar* _edgeType = edgeType.ptr<uchar>(i); // Gives _edgeType to point to the beginning of row i
 
-				p_res = magnitude.ptr<float>(i);
-				p_res_t = magnitude.ptr<float>(i - 1);
-				p_res_b = magnitude.ptr<float>(i + 1);
+				const float* p_res = magnitude.ptr<float>(i);
+				const float* p_res_t = magnitude.ptr<float>(i - 1);
+				const float* p_res_b = magnitude.ptr<float>(i + 1);
 
-				p_x = dx.ptr<float>(i);
-				p_y = dy.ptr<float>(i);
+				const float* p_x = dx.ptr<float>(i);
+				const float* p_y = dy.ptr<float>(i);
 
 				for (int j = 1; j < magnitude.cols - 1; j++)
 				{
@@ -105,8 +359,8 @@ namespace vision {
 
 					float iy = p_y[j];
 					float ix = p_x[j];
-					float y = abs((double)iy);
-					float x = abs((double)ix);
+					float y = std::abs(iy);
+					float x = std::abs(ix);
 
 					uchar val = p_res[j] > high_th ? 255 : 128;
 
@@ -140,49 +394,307 @@ namespace vision {
 					}
 				}
 			}
+		}
+
+		/* Step 4: Hystheresis */
+		// Depth-first growth from the strong pixels on a bounded stack. A pixel is
+		// pushed at most once: accepting it clears its edgeType entry, so edgeType
+		// is consumed here and every neighbour test is a single load. Candidates
+		// are never on the image border (NMS leaves it zero), so the eight
+		// precomputed neighbour offsets need no bounds checks.
+		//
+		// Strong pixels only seed in rows <= rows - 3, as in the original
+		// row-offset BFS, so the edge map is bit-identical to it.
+		//
+		// Work splits into row strips: traceStrip() only follows neighbours inside
+		// its rows and spills the ones outside, which traceSpill() then finishes.
+		// Within a strip the stack never holds more than the strip's pixels.
+
+		// Skips to the next strong pixel of a row, or returns end
+		static inline int nextStrong(const uchar* p, int x, int end) {
+#if defined(VISION_SIMD_SSE2)
+			const __m128i full = _mm_set1_epi8((char)255);
+			while (x <= end - 16 && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + x)), full)) == 0)
+				x += 16;
+#endif
+			while (x < end && p[x] != 255)
+				x++;
+			return x;
+		}
+
+		int CannyEngine::traceStrip(int rowBegin, int rowEnd, int* stack, int* spill, std::vector<int>* accepted) {
+			const int cols = size.width;
+			const int offsets[8] = { -cols - 1, -cols, -cols + 1, -1, 1, cols - 1, cols, cols + 1 };
+			const int first = rowBegin * cols, last = rowEnd * cols; // strip pixel range
+			const int seedEnd = std::min(rowEnd, size.height - 2);
+			uchar* type = edgeType.data;
+			uchar* out = edge.data;
+			int spilled = 0;
 
-			/* Step 4: Hystheresis */
-			int pic_x = edgeType.cols;
-			int pic_y = edgeType.rows;
-			int area = pic_x * pic_y;
-			int lines_idx = 0;
-			int idx = 0;
+			for (int i = std::max(rowBegin, 1); i < seedEnd; i++) {
+				const uchar* row = type + i * cols;
+				for (int j = nextStrong(row, 0, cols); j < cols; j = nextStrong(row, j + 1, cols)) {
+					int top = 0;
+					stack[top++] = i * cols + j;
+					out[i * cols + j] = 255;
+					type[i * cols + j] = 0;
+					if (accepted)
+						accepted->push_back(i * cols + j);
+					while (top > 0) {
+						const int pos = stack[--top];
+						for (int k = 0; k < 8; k++) {
+							const int n = pos + offsets[k];
+							if (n < first || n >= last) {
+								// other strip; decided in traceSpill()
+								spill[spilled++] = n;
+								continue;
+							}
+							if (type[n] == 0)
+								continue;
+							type[n] = 0;
+							out[n] = 255;
+							stack[top++] = n;
+							if (accepted)
+								accepted->push_back(n);
+						}
+					}
+				}
+			}
+			return spilled;
+		}
 
-			std::vector<int> lines;
-			edge.setTo(0);
-			for (int i = 1; i < pic_y - 1; i++) {
-				for (int j = 1; j < pic_x - 1; j++) {
+		void CannyEngine::traceSpill(const int* spill, int count, int* stack, std::vector<int>* accepted) {
+			const int cols = size.width;
+			const int offsets[8] = { -cols - 1, -cols, -cols + 1, -1, 1, cols - 1, cols, cols + 1 };
+			uchar* type = edgeType.data;
+			uchar* out = edge.data;
+			for (int s = 0; s < count; s++) {
+				if (type[spill[s]] == 0)
+					continue;
+				int top = 0;
+				stack[top++] = spill[s];
+				out[spill[s]] = 255;
+				type[spill[s]] = 0;
+				if (accepted)
+					accepted->push_back(spill[s]);
+				while (top > 0) {
+					const int pos = stack[--top];
+					for (int k = 0; k < 8; k++) {
+						const int n = pos + offsets[k];
+						if (type[n] == 0)
+							continue;
+						type[n] = 0;
+						out[n] = 255;
+						stack[top++] = n;
+						if (accepted)
+							accepted->push_back(n);
+					}
+				}
+			}
+		}
+
+		/* Integer Step 1: CV_16S Sobel */
+		void CannyEngine::derivativesInt(const cv::Mat& in, bool blurImage) {
+			CV_Assert(in.depth() == CV_8U);
+			const cv::Mat* src = &in;
+			if (blurImage) {
+				cv::GaussianBlur(in, blurred, cv::Size(5, 5), 1.5, 1.5, cv::BORDER_REPLICATE);
+				src = &blurred;
+			}
+
+			const int ksize = gradientMode == GradientMode::Integer3 ? 3 : gradientMode == GradientMode::Integer5 ? 5 : 7;
+			const double scale = ksize == 7 ? kSobel7Scale : 1.0;
+			cv::Sobel(*src, dx16, CV_16S, 1, 0, ksize, scale, 0, cv::BORDER_REPLICATE);
+			cv::Sobel(*src, dy16, CV_16S, 0, 1, ksize, scale, 0, cv::BORDER_REPLICATE);
+		}
+
+		// Magnitude, direction map and per-value counts of rows [rowBegin, rowEnd)
+		// in one pass; returns their maximum magnitude
+		int CannyEngine::magnitudeBandInt(int rowBegin, int rowEnd, bool useL2, int* counts) {
+			std::fill(counts, counts + kMaxMagnitude + 1, 0);
+			int maxMag = 0;
+			for (int i = rowBegin; i < rowEnd; i++) {
+				ushort* p_mag = magnitude16.ptr<ushort>(i);
+				maxMag = std::max(maxMag, magnitudeRow(dx16.ptr<short>(i), dy16.ptr<short>(i), p_mag, direction.ptr<uchar>(i), size.width, useL2));
+				for (int j = 0; j < size.width; j++)
+					counts[p_mag[j]]++;
+			}
+			return maxMag;
+		}
+
+		/* Integer Step 2: fold the per-value counts into the normalized histogram */
+		// Thresholds come back in magnitude units: a pixel is kept from lowTh up and
+		// is strong above highTh, matching m < low / m > high on m / maxMag.
+		void CannyEngine::thresholdsInt(int maxMag, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio, int& lowTh, int& highTh) {
+			int* hist = histogram.data();
+			// bin = round((bins - 1) * v / maxMag)
+			for (int b = 0; b < bands; b++) {
+				const int* counts = bandCounts.data() + (size_t)b * (kMaxMagnitude + 1);
+				for (int v = 0; v <= maxMag; v++)
+					hist[(2 * v * (bins - 1) + maxMag) / (2 * maxMag)] += counts[v];
+			}
+
+			float low = 0;
+			float high = 0;
+			pickThresholds(histogram, size.area(), nonEdgePixelsRatio, lowHighThresholdRatio, low, high);
+			lowTh = static_cast<int>(std::ceil((double)low * maxMag));
+			highTh = static_cast<int>(std::floor((double)high * maxMag));
+		}
 
-					if (edgeType.data[idx + j] != 255 || edge.data[idx + j] != 0)
+		/* Integer Step 3: NMS driven by the direction map */
+		void CannyEngine::nonMaximumSuppressionInt(int rowBegin, int rowEnd, int low_th, int high_th) {
+			const int cols = size.width;
+			std::memset(edgeType.ptr<uchar>(rowBegin), 0, (size_t)(rowEnd - rowBegin) * cols);
+			for (int i = std::max(rowBegin, 1); i < std::min(rowEnd, size.height - 1); i++)
+			{
+				uchar* _edgeType = edgeType.ptr<uchar>(i);
+				const ushort* p_res = magnitude16.ptr<ushort>(i);
+				const ushort* p_res_t = magnitude16.ptr<ushort>(i - 1);
+				const ushort* p_res_b = magnitude16.ptr<ushort>(i + 1);
+				const uchar* p_dir = direction.ptr<uchar>(i);
+
+				int j = 1;
+#if defined(VISION_SIMD_SSE2)
+				// Magnitudes stay below 2^15, so the signed compares are exact.
+				// Per lane: a is the neighbour that must be strictly smaller, c the one that may tie.
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i lowMinus1 = _mm_set1_epi16((short)(low_th - 1));
+				const __m128i high = _mm_set1_epi16((short)std::min(high_th, kMaxMagnitude));
+				const __m128i weak = _mm_set1_epi16(128);
+				const __m128i strongBits = _mm_set1_epi16(127);
+				for (; j <= cols - 1 - 8; j += 8) {
+					const __m128i m = _mm_loadu_si128((const __m128i*)(p_res + j));
+					const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p_dir + j)), zero);
+					const __m128i d0 = _mm_cmpeq_epi16(d, zero);
+					const __m128i d1 = _mm_cmpeq_epi16(d, _mm_set1_epi16(DirVertical));
+					const __m128i d2 = _mm_cmpeq_epi16(d, _mm_set1_epi16(DirDiagonal));
+					const __m128i d3 = _mm_cmpeq_epi16(d, _mm_set1_epi16(DirAntiDiagonal));
+
+					const __m128i a = _mm_or_si128(
+						_mm_or_si128(_mm_and_si128(d0, _mm_loadu_si128((const __m128i*)(p_res + j - 1))),
+							_mm_and_si128(d1, _mm_loadu_si128((const __m128i*)(p_res_b + j)))),
+						_mm_or_si128(_mm_and_si128(d2, _mm_loadu_si128((const __m128i*)(p_res_t + j - 1))),
+							_mm_and_si128(d3, _mm_loadu_si128((const __m128i*)(p_res_b + j - 1)))));
+					const __m128i c = _mm_or_si128(
+						_mm_or_si128(_mm_and_si128(d0, _mm_loadu_si128((const __m128i*)(p_res + j + 1))),
+							_mm_and_si128(d1, _mm_loadu_si128((const __m128i*)(p_res_t + j)))),
+						_mm_or_si128(_mm_and_si128(d2, _mm_loadu_si128((const __m128i*)(p_res_b + j + 1))),
+							_mm_and_si128(d3, _mm_loadu_si128((const __m128i*)(p_res_t + j + 1)))));
+
+					__m128i keep = _mm_and_si128(_mm_cmpgt_epi16(m, a), _mm_cmpgt_epi16(m, lowMinus1));
+					keep = _mm_andnot_si128(_mm_cmpgt_epi16(c, m), keep);
+					const __m128i val = _mm_or_si128(weak, _mm_and_si128(_mm_cmpgt_epi16(m, high), strongBits));
+					const __m128i out = _mm_and_si128(keep, val);
+					_mm_storel_epi64((__m128i*)(_edgeType + j), _mm_packus_epi16(out, out));
+				}
+#endif
+				for (; j < cols - 1; j++)
+				{
+					const int m = p_res[j];
+					if (m < low_th)
 						continue;
 
-					edge.data[idx + j] = 255;
-					lines_idx = 1;
-					lines.clear();
-					lines.push_back(idx + j);
-					int akt_idx = 0;
+					int a, c;
+					switch (p_dir[j]) {
+					case DirHorizontal: a = p_res[j - 1]; c = p_res[j + 1]; break;
+					case DirVertical: a = p_res_b[j]; c = p_res_t[j]; break;
+					case DirDiagonal: a = p_res_t[j - 1]; c = p_res_b[j + 1]; break;
+					default: a = p_res_b[j - 1]; c = p_res_t[j + 1]; break;
+					}
+					if (m > a && m >= c)
+						_edgeType[j] = m > high_th ? 255 : 128;
+				}
+			}
+		}
 
-					while (akt_idx < lines_idx) {
-						int akt_pos = lines[akt_idx];
-						akt_idx++;
+		const cv::Mat& CannyEngine::detect(const cv::Mat& in, bool blurImage, bool useL2, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio) {
+			CV_Assert(!in.empty());
+			CV_Assert(in.channels() == 1);
+			CV_Assert(bins > 0);
 
-						if (akt_pos - pic_x - 1 < 0 || akt_pos + pic_x + 1 >= area)
-							continue;
+			prepare(in.size(), bins);
+			const bool integer = isIntegerMode();
+			if (integer)
+				derivativesInt(in, blurImage);
+			else
+				derivatives(in, blurImage);
 
-						for (int k1 = -1; k1 < 2; k1++)
-							for (int k2 = -1; k2 < 2; k2++) {
-								if (edge.data[(akt_pos + (k1 * pic_x)) + k2] != 0 || edgeType.data[(akt_pos + (k1 * pic_x)) + k2] == 0)
-									continue;
-								edge.data[(akt_pos + (k1 * pic_x)) + k2] = 255;
-								lines.push_back((akt_pos + (k1 * pic_x)) + k2);
-								lines_idx++;
-							}
+			// Magnitude, NMS and hysteresis run in row bands, one pass at a time:
+			// NMS reads a row beyond its band and a band's trace spills the
+			// neighbours in the next band, so each pass needs the previous one
+			// finished everywhere. The spills are traced serially at the end.
+			// Every pass is per-pixel or an exact count, and the traced set does
+			// not depend on the order it is grown in, so the edges are the same
+			// for any band count.
+			const int cols = size.width;
+			float maxMag = 0;
+			float low_th = 0, high_th = 0;
+			int lowInt = 0, highInt = 0;
+#pragma omp parallel if (bands > 1)
+			{
+#pragma omp for schedule(static)
+				for (int b = 0; b < bands; b++) {
+					if (integer)
+						bandMax[b] = static_cast<float>(magnitudeBandInt(bandRow(b), bandRow(b + 1), useL2, bandCounts.data() + (size_t)b * (kMaxMagnitude + 1)));
+					else
+						bandMax[b] = magnitudeBand(bandRow(b), bandRow(b + 1), useL2);
+				}
+#pragma omp single
+				maxMag = *std::max_element(bandMax.begin(), bandMax.end());
+
+				// a flat image has no edges
+				if (maxMag > 0) {
+					if (integer) {
+#pragma omp single
+						thresholdsInt(static_cast<int>(maxMag), bins, nonEdgePixelsRatio, lowHighThresholdRatio, lowInt, highInt);
+					}
+					else {
+#pragma omp for schedule(static)
+						for (int b = 0; b < bands; b++)
+							normalizeBand(bandRow(b), bandRow(b + 1), maxMag, bandHistograms.data() + (size_t)b * bins, bins);
+#pragma omp single
+						thresholds(bins, nonEdgePixelsRatio, lowHighThresholdRatio, low_th, high_th);
+					}
+
+#pragma omp for schedule(static)
+					for (int b = 0; b < bands; b++) {
+						if (integer)
+							nonMaximumSuppressionInt(bandRow(b), bandRow(b + 1), lowInt, highInt);
+						else
+							nonMaximumSuppression(bandRow(b), bandRow(b + 1), low_th, high_th);
+					}
+
+#pragma omp for schedule(static)
+					for (int b = 0; b < bands; b++) {
+						const int rowBegin = bandRow(b), rowEnd = bandRow(b + 1);
+						std::memset(edge.ptr<uchar>(rowBegin), 0, (size_t)(rowEnd - rowBegin) * cols);
+						std::vector<int>* accepted = nullptr;
+						if (collectPixels) {
+							bandPixels[b].clear();
+							accepted = &bandPixels[b];
+						}
+						bandSpilled[b] = traceStrip(rowBegin, rowEnd, traceStack.data() + (size_t)rowBegin * cols,
+							spillBuffer.data() + (size_t)b * 6 * cols, accepted);
 					}
 				}
-				idx += pic_x;
 			}
 
+			edgePixels.clear();
+			if (maxMag <= 0) {
+				edge.setTo(0);
+				return edge;
+			}
+			if (collectPixels)
+				for (int b = 0; b < bands; b++)
+					edgePixels.insert(edgePixels.end(), bandPixels[b].begin(), bandPixels[b].end());
+			for (int b = 0; b < bands; b++)
+				traceSpill(spillBuffer.data() + (size_t)b * 6 * cols, bandSpilled[b], traceStack.data(), collectPixels ? &edgePixels : nullptr);
 			return edge;
 		}
+
+		cv::Mat canny(const cv::Mat& in, bool blurImage, bool useL2, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio) {
+			thread_local CannyEngine engine;
+			return engine.detect(in, blurImage, useL2, bins, nonEdgePixelsRatio, lowHighThresholdRatio).clone();
+		}
 	}
-}
\ No newline at end of file
+}
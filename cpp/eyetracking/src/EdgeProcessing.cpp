@@ -1,5 +1,12 @@
 #include "EdgeProcessing.h"
 #include "Utils.h"
+#include "Simd.h"
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace vision {
 	namespace edge {
@@ -276,5 +283,618 @@ namespace vision {
             filterEdges(dst);
             return dst;
         }
+
+        // ------------------------------------------------------------------
+        // EdgeFilter
+        // ------------------------------------------------------------------
+
+        // The rules only touch pixels this far from the border
+        static const int kMargin = 5;
+
+        // Above one edge pixel in this many the sparse call runs the whole-map
+        // passes instead: nearly every word holds a pixel, and packing the map
+        // beats scattering the list
+        static const int kSparseMaxDensity = 32;
+
+        static inline int lowestBit(uint64_t v) {
+#if defined(_MSC_VER)
+            unsigned long i;
+            _BitScanForward64(&i, v);
+            return static_cast<int>(i);
+#else
+            return __builtin_ctzll(v);
+#endif
+        }
+
+        // First set pixel in [x, end) of a packed row, or end
+        static inline int nextSet(const uint64_t* row, int x, int end) {
+            if (x >= end)
+                return end;
+            int w = x >> 6;
+            uint64_t v = row[w] & (~0ull << (x & 63));
+            while (!v) {
+                if (++w << 6 >= end)
+                    return end;
+                v = row[w];
+            }
+            return std::min((w << 6) + lowestBit(v), end);
+        }
+
+        // Pixels x - 3 .. x + 3 of a packed row as bits 0..6
+        static inline unsigned window7(const uint64_t* row, int x) {
+            const int s = x - 3;
+            const int w = s >> 6, o = s & 63;
+            uint64_t v = row[w] >> o;
+            if (o > 57)
+                v |= row[w + 1] << (64 - o);
+            return static_cast<unsigned>(v & 127);
+        }
+
+        static inline void setPixel(uint64_t* row, int x, bool on) {
+            const uint64_t bit = 1ull << (x & 63);
+            if (on)
+                row[x >> 6] |= bit;
+            else
+                row[x >> 6] &= ~bit;
+        }
+
+        // Pixels of k take the value !(left neighbour), left to right; f holds
+        // the already decided pixels of the word and carry the pixel before it.
+        // In place, a pixel's left neighbour is final when it is visited, so
+        // these are the only pixels of a row that have to go one by one.
+        static inline uint64_t resolveLeft(uint64_t f, uint64_t k, uint64_t carry) {
+            while (k) {
+                const int b = lowestBit(k);
+                const uint64_t left = b ? (f >> (b - 1)) & 1 : carry;
+                if (!left)
+                    f |= 1ull << b;
+                k &= k - 1;
+            }
+            return f;
+        }
+
+        // A rule term: pixels (dy, dx) from the centre that must be set / clear
+        struct Literal { int dy, dx; bool set; };
+        typedef std::vector<Literal> Term;
+
+        // Per-row lookup of rule terms over window rows top .. top + rows - 1 and
+        // columns -3..3. Entry [r][p] has bit t set when the 7-pixel pattern p of
+        // row r meets every literal term t has in that row.
+        struct TermTable {
+            int top = 0;
+            std::vector<uint32_t> entries; // rows x 128
+
+            TermTable(int top, int rows, const std::vector<Term>& terms) : top(top), entries((size_t)rows * 128, 0) {
+                CV_Assert(terms.size() <= 32);
+                for (int r = 0; r < rows; r++)
+                    for (unsigned p = 0; p < 128; p++)
+                        for (size_t t = 0; t < terms.size(); t++) {
+                            bool ok = true;
+                            for (const Literal& l : terms[t])
+                                if (l.dy == top + r && (((p >> (l.dx + 3)) & 1) != 0) != l.set)
+                                    ok = false;
+                            if (ok)
+                                entries[r * 128 + p] |= 1u << t;
+                        }
+            }
+
+            // Terms met by the window around pixel x of the row at center
+            uint32_t match(const uint64_t* center, int stride, int x) const {
+                const int rows = static_cast<int>(entries.size() / 128);
+                uint32_t m = ~0u;
+                for (int r = 0; r < rows && m; r++)
+                    m &= entries[r * 128 + window7(center + (ptrdiff_t)(top + r) * stride, x)];
+                return m;
+            }
+        };
+
+        // One term per combination of base with a literal from each group
+        static void addRule(std::vector<Term>& terms, const Term& base, const std::vector<Term>& anyOf) {
+            std::vector<Term> out(1, base);
+            for (const Term& group : anyOf) {
+                std::vector<Term> next;
+                for (const Term& t : out)
+                    for (const Literal& l : group) {
+                        next.push_back(t);
+                        next.back().push_back(l);
+                    }
+                out.swap(next);
+            }
+            terms.insert(terms.end(), out.begin(), out.end());
+        }
+
+        // Straightening: four rules, each moving a staircase step onto the
+        // straight line below or to the right of the centre. Entries: the terms
+        // of rule k are the bits of ruleTerms[k], its writes are actions[k].
+        struct StraightenRules {
+            TermTable table;
+            uint32_t ruleTerms[4];
+            Term actions[4];
+
+            static std::vector<Term> terms() {
+                std::vector<Term> t;
+                addRule(t, { { 2, 0, true }, { 1, 0, false } }, { { { 1, 1, true }, { 1, -1, true } } });
+                addRule(t, { { 3, 0, true }, { 1, 0, false }, { 2, 0, false } },
+                    { { { 1, 1, true }, { 1, -1, true } }, { { 2, 1, true }, { 2, -1, true } } });
+                addRule(t, { { 0, 2, true }, { 0, 1, false } }, { { { 1, 1, true }, { -1, 1, true } } });
+                addRule(t, { { 0, 3, true }, { 0, 1, false }, { 0, 2, false } },
+                    { { { 1, 1, true }, { -1, 1, true } }, { { 1, 2, true }, { -1, 2, true } } });
+                return t;
+            }
+
+            StraightenRules() : table(-1, 5, terms()) {
+                ruleTerms[0] = 0x3;
+                ruleTerms[1] = 0x3c;
+                ruleTerms[2] = 0xc0;
+                ruleTerms[3] = 0xf00;
+                actions[0] = { { 1, -1, false }, { 1, 1, false }, { 1, 0, true } };
+                actions[1] = { { 1, 1, false }, { 1, -1, false }, { 2, 1, false }, { 2, -1, false }, { 1, 0, true }, { 2, 0, true } };
+                actions[2] = { { 1, 1, false }, { -1, 1, false }, { 0, 1, true } };
+                actions[3] = { { 1, 1, false }, { -1, 1, false }, { 1, 2, false }, { -1, 2, false }, { 0, 1, true }, { 0, 2, true } };
+            }
+        };
+
+        // Thinning: the centre goes when any of these pixel sets is complete
+        static std::vector<Term> thinningTerms() {
+            const int sets[16][6][2] = {
+                { { 1, 0 }, { -1, 1 }, { -1, 2 } },
+                { { 1, 0 }, { -1, -1 }, { -1, -2 } },
+                { { -1, 0 }, { 1, 1 }, { 1, 2 } },
+                { { -1, 0 }, { 1, -1 }, { 1, -2 } },
+                { { -1, -1 }, { -2, -1 }, { -3, -1 }, { 1, 1 }, { 1, 2 }, { 1, 3 } },
+                { { -1, 1 }, { -2, 1 }, { -3, 1 }, { 1, -1 }, { 1, -2 }, { 1, -3 } },
+                { { 1, -1 }, { 2, -1 }, { 3, -1 }, { -1, 1 }, { -1, 2 }, { -1, 3 } },
+                { { 1, 1 }, { 2, 1 }, { 3, 1 }, { -1, -1 }, { -1, -2 }, { -1, -3 } },
+                { { -1, -1 }, { -2, -2 }, { -1, 1 }, { -2, 2 } },
+                { { -1, -1 }, { -2, -2 }, { 1, -1 }, { 2, -2 } },
+                { { 1, 1 }, { 2, 2 }, { -1, 1 }, { -2, 2 } },
+                { { 1, 1 }, { 2, 2 }, { 1, -1 }, { 2, -2 } },
+                { { 0, -1 }, { -1, -2 }, { -2, -3 }, { -1, 1 }, { -2, 2 } },
+                { { 0, -1 }, { 1, -2 }, { 2, -3 }, { 1, 1 }, { 2, 2 } },
+                { { 1, 0 }, { 2, 1 }, { 3, 2 }, { -1, 1 }, { -2, 2 } },
+                { { 1, 0 }, { 2, -1 }, { 3, -2 }, { -1, -1 }, { -2, -2 } },
+            };
+            const int counts[16] = { 3, 3, 3, 3, 6, 6, 6, 6, 4, 4, 4, 4, 5, 5, 5, 5 };
+            std::vector<Term> terms(16);
+            for (int t = 0; t < 16; t++)
+                for (int k = 0; k < counts[t]; k++)
+                    terms[t].push_back({ sets[t][k][0], sets[t][k][1], true });
+            return terms;
+        }
+
+        void EdgeFilter::resize(cv::Size newSize) {
+            if (newSize == size)
+                return;
+            size = newSize;
+            const int words = (size.width + 63) / 64;
+            stride = words + 1;
+            bits.assign((size_t)stride * size.height, 0);
+            clear = true;
+            columnMask.assign(stride, 0);
+            for (int x = kMargin; x < size.width - kMargin; x++)
+                columnMask[x >> 6] |= 1ull << (x & 63);
+        }
+
+        void EdgeFilter::pack(const cv::Mat& edges) {
+            resize(edges.size());
+            clear = false;
+            for (int y = 0; y < size.height; y++) {
+                const uchar* src = edges.ptr<uchar>(y);
+                uint64_t* dst = row(y);
+                std::fill(dst, dst + stride, 0);
+                int x = 0;
+#if defined(VISION_SIMD_SSE2)
+                const __m128i zero = _mm_setzero_si128();
+                for (; x <= size.width - 16; x += 16) {
+                    const int m = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + x)), zero)) & 0xFFFF;
+                    dst[x >> 6] |= (uint64_t)m << (x & 63);
+                }
+#endif
+                for (; x < size.width; x++)
+                    if (src[x])
+                        dst[x >> 6] |= 1ull << (x & 63);
+            }
+        }
+
+        // Bits x0 .. x0 + n - 1 of a row to 0 / 255 bytes
+        static inline void unpackBits(const uint64_t* src, int x0, int n, uchar* dst) {
+            int x = x0;
+            const int end = x0 + n;
+#if defined(VISION_SIMD_SSE2)
+            const __m128i select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            for (; x <= end - 16; x += 16) {
+                const unsigned m = static_cast<unsigned>(src[x >> 6] >> (x & 63));
+                const __m128i v = _mm_unpacklo_epi64(_mm_set1_epi8((char)(m & 255)), _mm_set1_epi8((char)((m >> 8) & 255)));
+                _mm_storeu_si128((__m128i*)(dst + x), _mm_cmpeq_epi8(_mm_and_si128(v, select), select));
+            }
+#endif
+            for (; x < end; x++)
+                dst[x] = (src[x >> 6] >> (x & 63)) & 1 ? 255 : 0;
+        }
+
+        void EdgeFilter::unpack(cv::Mat& edges) const {
+            for (int y = 0; y < size.height; y++)
+                unpackBits(bits.data() + (size_t)y * stride, 0, size.width, edges.ptr<uchar>(y));
+        }
+
+        // Pass 1 on word w of a row: a pixel with a horizontal and a vertical
+        // 4-neighbour goes. Right and below are not visited yet, up and left are
+        // final, and so is the last pixel of the previous word.
+        static inline void crossPruneWord(uint64_t* cur, const uint64_t* up, const uint64_t* down, uint64_t columns, int w) {
+            const uint64_t c = cur[w];
+            if (!c)
+                return;
+            const uint64_t carry = w ? cur[w - 1] >> 63 : 0;
+            const uint64_t right = (c >> 1) | (cur[w + 1] << 63);
+            const uint64_t active = c & columns & (up[w] | down[w]);
+            cur[w] = resolveLeft(c & ~active, active & ~right, carry);
+        }
+
+        // Pass 2 on word w of a row: a pixel goes when its 3x3 box holds more
+        // than 3 pixels. Counts are bit-sliced over the seven neighbours other
+        // than the left one.
+        static inline void pruneCrowdedWord(uint64_t* cur, const uint64_t* up, const uint64_t* down, uint64_t columns, int w) {
+            const uint64_t c = cur[w];
+            if (!c)
+                return;
+            const uint64_t carry = w ? cur[w - 1] >> 63 : 0;
+            const uint64_t upPrev = w ? up[w - 1] : 0, downPrev = w ? down[w - 1] : 0;
+            const uint64_t right = (c >> 1) | (cur[w + 1] << 63);
+            const uint64_t ul = (up[w] << 1) | (upPrev >> 63), ur = (up[w] >> 1) | (up[w + 1] << 63);
+            const uint64_t dl = (down[w] << 1) | (downPrev >> 63), dr = (down[w] >> 1) | (down[w + 1] << 63);
+
+            // full adders: n = s0 + 2 * s1 + 4 * s2
+            const uint64_t a0 = right ^ ul ^ up[w], a1 = (right & ul) | (up[w] & (right ^ ul));
+            const uint64_t b0 = ur ^ dl ^ down[w], b1 = (ur & dl) | (down[w] & (ur ^ dl));
+            const uint64_t s0 = a0 ^ b0 ^ dr, c1 = (a0 & b0) | (dr & (a0 ^ b0));
+            const uint64_t s1 = a1 ^ b1 ^ c1, s2 = (a1 & b1) | (c1 & (a1 ^ b1));
+
+            // centre + n + left <= 3: n <= 1 stays, n == 2 stays without a left neighbour
+            const uint64_t active = c & columns;
+            const uint64_t stays = ~s2 & ~s1;
+            const uint64_t needsClearLeft = ~s2 & s1 & ~s0;
+            cur[w] = resolveLeft((c & ~active) | (active & stays), active & needsClearLeft, carry);
+        }
+
+        // Pass 3 on word w of row y: straightening. Writes reach one row up, two
+        // rows down and two columns right, so pixels go one at a time on the live
+        // map; the word is re-read after each, which also picks up pixels set
+        // ahead in it. Words outside it that were empty and get a pixel are
+        // reported to filled, if given.
+        void EdgeFilter::straightenWord(int y, int w, std::vector<int>* filled) {
+            static const StraightenRules rules;
+            uint64_t* cur = row(y);
+            for (int b = 0; b < 64; b++) {
+                const uint64_t v = cur[w] & columnMask[w] & (~0ull << b);
+                if (!v)
+                    return;
+                b = lowestBit(v);
+                const int x = (w << 6) + b;
+                const uint32_t m = rules.table.match(cur, stride, x);
+                if (!m)
+                    continue;
+                for (int k = 0; k < 4; k++) {
+                    if (!(m & rules.ruleTerms[k]))
+                        continue;
+                    for (const Literal& l : rules.actions[k]) {
+                        uint64_t* target = cur + (ptrdiff_t)l.dy * stride;
+                        // Only words that were empty are reported: writes into the
+                        // current word (dy = 0, x + dx still inside it) never are,
+                        // since it holds x, so filled gets no duplicates
+                        const int tw = (x + l.dx) >> 6;
+                        if (filled && l.set && !target[tw])
+                            filled->push_back(y * stride + l.dy * stride + tw);
+                        setPixel(target, x + l.dx, l.set);
+                    }
+                }
+            }
+        }
+
+        // Pass 4 on word w of row y: thinning, only ever clears the centre
+        void EdgeFilter::thinWord(int y, int w) {
+            static const TermTable table(-3, 7, thinningTerms());
+            uint64_t* cur = row(y);
+            for (int b = 0; b < 64; b++) {
+                const uint64_t v = cur[w] & columnMask[w] & (~0ull << b);
+                if (!v)
+                    return;
+                b = lowestBit(v);
+                const int x = (w << 6) + b;
+                if (table.match(cur, stride, x))
+                    setPixel(cur, x, false);
+            }
+        }
+
+        void EdgeFilter::crossPrune() {
+            for (int y = kMargin; y < size.height - kMargin; y++)
+                for (int w = 0; w < stride - 1; w++)
+                    crossPruneWord(row(y), row(y - 1), row(y + 1), columnMask[w], w);
+        }
+
+        void EdgeFilter::pruneCrowded() {
+            for (int y = kMargin; y < size.height - kMargin; y++)
+                for (int w = 0; w < stride - 1; w++)
+                    pruneCrowdedWord(row(y), row(y - 1), row(y + 1), columnMask[w], w);
+        }
+
+        void EdgeFilter::straighten() {
+            for (int y = kMargin; y < size.height - kMargin; y++)
+                for (int w = 0; w < stride - 1; w++)
+                    straightenWord(y, w, nullptr);
+        }
+
+        void EdgeFilter::thin() {
+            for (int y = kMargin; y < size.height - kMargin; y++)
+                for (int w = 0; w < stride - 1; w++)
+                    thinWord(y, w);
+        }
+
+        // Sparse passes run the same word passes, but only on the listed words
+        // (y * stride + w, ascending). Visiting the non-empty words in raster
+        // order is exactly the full scan, which skips the empty ones.
+
+        // Splits ascending linear indices into (column, row) without a division
+        struct RasterCursor {
+            int cols, y = 0, rowStart = 0;
+            explicit RasterCursor(int cols) : cols(cols) {}
+            int column(int p) {
+                while (p >= rowStart + cols) {
+                    rowStart += cols;
+                    y++;
+                }
+                return p - rowStart;
+            }
+        };
+
+        void EdgeFilter::crossPrune(const std::vector<int>& words) {
+            RasterCursor at(stride);
+            for (int i : words) {
+                const int w = at.column(i), y = at.y;
+                if (y >= kMargin && y < size.height - kMargin)
+                    crossPruneWord(row(y), row(y - 1), row(y + 1), columnMask[w], w);
+            }
+        }
+
+        void EdgeFilter::pruneCrowded(const std::vector<int>& words) {
+            RasterCursor at(stride);
+            for (int i : words) {
+                const int w = at.column(i), y = at.y;
+                if (y >= kMargin && y < size.height - kMargin)
+                    pruneCrowdedWord(row(y), row(y - 1), row(y + 1), columnMask[w], w);
+            }
+        }
+
+        // Straightening only fills words ahead in raster order, so those are
+        // merged in from a min-heap as the scan reaches them. A word can come
+        // from both sides (or twice from the heap); repeats are adjacent.
+        void EdgeFilter::straighten(const std::vector<int>& words) {
+            visited.clear();
+            filled.clear();
+            heap.clear();
+            RasterCursor at(stride);
+            size_t next = 0;
+            int last = -1;
+            while (next < words.size() || !heap.empty()) {
+                int i;
+                if (!heap.empty() && (next == words.size() || heap.front() < words[next])) {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<int>());
+                    i = heap.back();
+                    heap.pop_back();
+                }
+                else {
+                    i = words[next++];
+                }
+                if (i == last)
+                    continue;
+                last = i;
+                visited.push_back(i);
+
+                const int w = at.column(i), y = at.y;
+                if (y < kMargin || y >= size.height - kMargin)
+                    continue;
+                straightenWord(y, w, &filled);
+                for (int f : filled) {
+                    heap.push_back(f);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<int>());
+                }
+                filled.clear();
+            }
+        }
+
+        void EdgeFilter::thin(const std::vector<int>& words) {
+            RasterCursor at(stride);
+            for (int i : words) {
+                const int w = at.column(i), y = at.y;
+                if (y >= kMargin && y < size.height - kMargin)
+                    thinWord(y, w);
+            }
+        }
+
+        void EdgeFilter::apply(cv::Mat& edges, std::vector<int>& pixels) {
+            CV_Assert(!edges.empty());
+            CV_Assert(edges.type() == CV_8UC1);
+            if (edges.cols <= 2 * kMargin || edges.rows <= 2 * kMargin) {
+                std::sort(pixels.begin(), pixels.end());
+                return;
+            }
+
+            if (pixels.size() * kSparseMaxDensity > edges.total()) {
+                apply(edges);
+                pixels.clear();
+                for (int y = 0; y < size.height; y++) {
+                    const uint64_t* cur = row(y);
+                    for (int w = 0; w < stride - 1; w++)
+                        for (uint64_t v = cur[w]; v; v &= v - 1)
+                            pixels.push_back(y * size.width + (w << 6) + lowestBit(v));
+                }
+                return;
+            }
+
+            resize(edges.size());
+            if (!clear)
+                std::fill(bits.begin(), bits.end(), 0);
+            const int cols = size.width;
+            // y = p / cols through the reciprocal, corrected for rounding
+            const double invCols = 1.0 / cols;
+            for (int p : pixels) {
+                int y = static_cast<int>(p * invCols);
+                y += (p - y * cols >= cols) - (p < y * cols);
+                setPixel(row(y), p - y * cols, true);
+            }
+            // Non-empty words in raster order: one test per 64 pixels, cheaper
+            // than sorting the pixel list
+            words.clear();
+            for (int i = 0; i < (int)bits.size(); i++)
+                if (bits[i])
+                    words.push_back(i);
+
+            crossPrune(words);
+            pruneCrowded(words);
+            straighten(words);
+            thin(visited);
+
+            // Write the visited words back, list their pixels and leave the bits
+            // clear again. Pixels of these words that were never set stay 0.
+            pixels.clear();
+            RasterCursor at(stride);
+            for (int i : visited) {
+                const int w = at.column(i), y = at.y;
+                const int x0 = w << 6;
+                unpackBits(row(y), x0, std::min(64, cols - x0), edges.ptr<uchar>(y));
+                for (uint64_t v = bits[i]; v; v &= v - 1)
+                    pixels.push_back(y * cols + x0 + lowestBit(v));
+                bits[i] = 0;
+            }
+            clear = true;
+        }
+
+        void EdgeFilter::apply(cv::Mat& edges) {
+            CV_Assert(!edges.empty());
+            CV_Assert(edges.type() == CV_8UC1);
+            if (edges.cols <= 2 * kMargin || edges.rows <= 2 * kMargin)
+                return;
+
+            pack(edges);
+            crossPrune();
+            pruneCrowded();
+            straighten();
+            thin();
+            unpack(edges);
+        }
+
+        void EdgeLinker::resize(cv::Size newSize) {
+            if (newSize == size)
+                return;
+            size = newSize;
+            stride = size.width + 2;
+            open.assign((size_t)(size.height + 2) * stride, 0);
+        }
+
+        void EdgeLinker::link(const cv::Mat& edges, LinkPoints mode) {
+            CV_Assert(!edges.empty());
+            CV_Assert(edges.type() == CV_8UC1);
+            resize(edges.size());
+
+            starts.clear();
+            for (int y = 0; y < size.height; y++) {
+                const uchar* src = edges.ptr<uchar>(y);
+                uchar* dst = open.data() + (size_t)(y + 1) * stride + 1;
+                const int base = (y + 1) * stride + 1;
+                int x = 0;
+                for (; x + 8 <= size.width; x += 8) {
+                    uint64_t v;
+                    std::memcpy(&v, src + x, 8);
+                    if (!v)
+                        continue;
+                    for (int i = x; i < x + 8; i++)
+                        if (src[i]) {
+                            dst[i] = 1;
+                            starts.push_back(base + i);
+                        }
+                }
+                for (; x < size.width; x++)
+                    if (src[x]) {
+                        dst[x] = 1;
+                        starts.push_back(base + x);
+                    }
+            }
+            trace(mode);
+        }
+
+        void EdgeLinker::link(const cv::Mat& edges, const std::vector<int>& pixels, LinkPoints mode) {
+            CV_Assert(!edges.empty());
+            CV_Assert(edges.type() == CV_8UC1);
+            resize(edges.size());
+
+            starts.clear();
+            for (int i : pixels) {
+                CV_DbgAssert(i >= 0 && i < size.area());
+                const int y = i / size.width;
+                const int x = i - y * size.width;
+                const int p = (y + 1) * stride + x + 1;
+                if (edges.ptr<uchar>(y)[x] && !open[p]) {
+                    open[p] = 1;
+                    starts.push_back(p);
+                }
+            }
+            trace(mode);
+        }
+
+        // Next unlinked neighbour of p (claimed), 4-neighbours first; -1 at an end
+        int EdgeLinker::step(int p) {
+            const int offsets[8] = { 1, stride, -1, -stride, stride + 1, stride - 1, -stride + 1, -stride - 1 };
+            for (int d : offsets) {
+                if (open[p + d]) {
+                    open[p + d] = 0;
+                    return p + d;
+                }
+            }
+            return -1;
+        }
+
+        void EdgeLinker::trace(LinkPoints mode) {
+            pointList.clear();
+            segmentList.clear();
+            for (int s : starts) {
+                if (!open[s])
+                    continue;
+                open[s] = 0;
+
+                // Forward from the start, then backward from it; chain ends up as
+                // the reversed backward run followed by the forward one
+                chain.clear();
+                chain.push_back(s);
+                for (int p = step(s); p >= 0; p = step(p))
+                    chain.push_back(p);
+                const size_t forward = chain.size();
+                for (int p = step(s); p >= 0; p = step(p))
+                    chain.push_back(p);
+                if (chain.size() > forward) {
+                    std::reverse(chain.begin() + forward, chain.end());
+                    std::rotate(chain.begin(), chain.begin() + forward, chain.end());
+                }
+
+                const int begin = (int)pointList.size();
+                emit(mode);
+                const int d = std::abs(chain.back() - chain.front());
+                const bool closed = chain.size() > 2 && (d == 1 || d == stride - 1 || d == stride || d == stride + 1);
+                segmentList.push_back({ begin, (int)pointList.size(), closed });
+            }
+        }
+
+        // Appends the chain's points in image coordinates
+        void EdgeLinker::emit(LinkPoints mode) {
+            const size_t n = chain.size();
+            auto point = [&](int p) {
+                const int y = p / stride;
+                return cv::Point(p - y * stride - 1, y - 1);
+            };
+            pointList.push_back(point(chain[0]));
+            for (size_t i = 1; i + 1 < n; i++)
+                if (mode == LinkPoints::All || chain[i] - chain[i - 1] != chain[i + 1] - chain[i])
+                    pointList.push_back(point(chain[i]));
+            if (n > 1)
+                pointList.push_back(point(chain[n - 1]));
+        }
 	}
 }
\ No newline at end of file
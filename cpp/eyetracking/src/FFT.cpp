@@ -0,0 +1,211 @@
+#include "FFT.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace vision {
+	namespace fft {
+		int nextPow2(int n) {
+			int p = 1;
+			while (p < n) p <<= 1;
+			return p;
+		}
+
+		RealFFTPlan::RealFFTPlan(int n) : n(n), half(n / 2) {
+			CV_Assert(n >= 2 && (n & (n - 1)) == 0);
+
+			int bits = 0;
+			while ((1 << bits) < half) ++bits;
+			rev.resize(half);
+			for (int i = 0; i < half; ++i) {
+				int r = 0;
+				for (int b = 0; b < bits; ++b)
+					if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+				rev[i] = r;
+			}
+
+			// Stage with half-length hl uses exp(-2*pi*i*j/(2*hl)), j < hl, stored from offset hl - 1
+			stageRe.resize(std::max(1, half - 1));
+			stageIm.resize(std::max(1, half - 1));
+			for (int hl = 1; hl < half; hl <<= 1) {
+				for (int j = 0; j < hl; ++j) {
+					double a = -M_PI * j / hl;
+					stageRe[hl - 1 + j] = static_cast<float>(std::cos(a));
+					stageIm[hl - 1 + j] = static_cast<float>(std::sin(a));
+				}
+			}
+
+			splitRe.resize(half / 2 + 1);
+			splitIm.resize(half / 2 + 1);
+			for (int k = 0; k <= half / 2; ++k) {
+				double a = -2.0 * M_PI * k / n;
+				splitRe[k] = static_cast<float>(std::cos(a));
+				splitIm[k] = static_cast<float>(std::sin(a));
+			}
+		}
+
+		const RealFFTPlan& RealFFTPlan::cached(int n) {
+			static std::mutex mutex;
+			static std::map<int, std::unique_ptr<RealFFTPlan>> plans;
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& plan = plans[n];
+			if (!plan)
+				plan.reset(new RealFFTPlan(n));
+			return *plan;
+		}
+
+		// One radix-2 butterfly across count values. The halves never overlap.
+		static inline void butterfly(float* __restrict r0, float* __restrict i0, float* __restrict r1,
+			float* __restrict i1, float c, float s, int count) {
+			for (int l = 0; l < count; ++l) {
+				float tr = c * r1[l] - s * i1[l];
+				float ti = c * i1[l] + s * r1[l];
+				r1[l] = r0[l] - tr;
+				i1[l] = i0[l] - ti;
+				r0[l] += tr;
+				i0[l] += ti;
+			}
+		}
+
+		// Butterflies with a per-element twiddle (single line transforms)
+		static inline void butterflyTwiddled(float* __restrict r0, float* __restrict i0, float* __restrict r1,
+			float* __restrict i1, const float* __restrict wr, const float* __restrict wi, int count) {
+			for (int j = 0; j < count; ++j) {
+				float tr = wr[j] * r1[j] - wi[j] * i1[j];
+				float ti = wr[j] * i1[j] + wi[j] * r1[j];
+				r1[j] = r0[j] - tr;
+				i1[j] = i0[j] - ti;
+				r0[j] += tr;
+				i0[j] += ti;
+			}
+		}
+
+		// In-place forward complex FFT of length half on bit-reversed input, L lanes
+		template<int L>
+		void RealFFTPlan::butterflies(float* re, float* im) const {
+			for (int hl = 1; hl < half; hl <<= 1) {
+				const float* wr = stageRe.data() + hl - 1;
+				const float* wi = stageIm.data() + hl - 1;
+				for (int i = 0; i < half; i += 2 * hl) {
+					float* r0 = re + i * L;
+					float* i0 = im + i * L;
+					if (L == 1) {
+						// Twiddles vary along j, run the j loop as the vector loop
+						butterflyTwiddled(r0, i0, r0 + hl, i0 + hl, wr, wi, hl);
+					}
+					else {
+						for (int j = 0; j < hl; ++j)
+							butterfly(r0 + j * L, i0 + j * L, r0 + (hl + j) * L, i0 + (hl + j) * L, wr[j], wi[j], L);
+					}
+				}
+			}
+		}
+
+		template<int L>
+		void RealFFTPlan::forwardImpl(const float* in, float* re, float* im) const {
+			// Even samples as re, odd samples as im, loaded in bit-reversed order
+			for (int k = 0; k < half; ++k) {
+				const float* src = in + 2 * k * L;
+				float* r = re + rev[k] * L;
+				float* m = im + rev[k] * L;
+				for (int l = 0; l < L; ++l) {
+					r[l] = src[l];
+					m[l] = src[L + l];
+				}
+			}
+			butterflies<L>(re, im);
+
+			// Split Z = FFT(even + i*odd) into the spectrum of the real signal
+			for (int l = 0; l < L; ++l) {
+				float r0 = re[l], i0 = im[l];
+				re[l] = r0 + i0; im[l] = 0.0f;
+				re[half * L + l] = r0 - i0; im[half * L + l] = 0.0f;
+			}
+			for (int k = 1; k <= half / 2; ++k) {
+				const float c = splitRe[k], s = splitIm[k];
+				float* rk = re + k * L;
+				float* ik = im + k * L;
+				float* rm = re + (half - k) * L;
+				float* im_ = im + (half - k) * L;
+				for (int l = 0; l < L; ++l) {
+					float ar = rk[l], ai = ik[l], br = rm[l], bi = im_[l];
+					float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+					float orr = 0.5f * (ai + bi), oi = -0.5f * (ar - br);
+					float tr = c * orr - s * oi;
+					float ti = c * oi + s * orr;
+					rk[l] = er + tr; ik[l] = ei + ti;
+					rm[l] = er - tr; im_[l] = ti - ei;
+				}
+			}
+		}
+
+		template<int L>
+		void RealFFTPlan::inverseImpl(float* re, float* im, float* out) const {
+			// Merge the spectrum back into Z, conjugated so the forward butterflies
+			// compute the inverse transform
+			for (int l = 0; l < L; ++l) {
+				float x0 = re[l], xh = re[half * L + l];
+				re[l] = 0.5f * (x0 + xh);
+				im[l] = -0.5f * (x0 - xh);
+			}
+			for (int k = 1; k <= half / 2; ++k) {
+				const float c = splitRe[k], s = splitIm[k];
+				float* rk = re + k * L;
+				float* ik = im + k * L;
+				float* rm = re + (half - k) * L;
+				float* im_ = im + (half - k) * L;
+				for (int l = 0; l < L; ++l) {
+					float ar = rk[l], ai = ik[l], br = rm[l], bi = im_[l];
+					float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+					float dr = ar - br, di = ai + bi;
+					float orr = 0.5f * (dr * c + di * s);
+					float oi = 0.5f * (di * c - dr * s);
+					rk[l] = er - oi; ik[l] = -(ei + orr);
+					rm[l] = er + oi; im_[l] = -(orr - ei);
+				}
+			}
+
+			for (int k = 0; k < half; ++k) {
+				int r = rev[k];
+				if (k < r) {
+					for (int l = 0; l < L; ++l) {
+						std::swap(re[k * L + l], re[r * L + l]);
+						std::swap(im[k * L + l], im[r * L + l]);
+					}
+				}
+			}
+			butterflies<L>(re, im);
+
+			const float scale = 1.0f / half;
+			for (int k = 0; k < half; ++k) {
+				float* dst = out + 2 * k * L;
+				for (int l = 0; l < L; ++l) {
+					dst[l] = re[k * L + l] * scale;
+					dst[L + l] = -im[k * L + l] * scale;
+				}
+			}
+		}
+
+		void RealFFTPlan::forward(const float* in, float* re, float* im) const {
+			forwardImpl<1>(in, re, im);
+		}
+
+		void RealFFTPlan::inverse(float* re, float* im, float* out) const {
+			inverseImpl<1>(re, im, out);
+		}
+
+		void RealFFTPlan::forwardBatch(const float* in, float* re, float* im) const {
+			forwardImpl<kLanes>(in, re, im);
+		}
+
+		void RealFFTPlan::inverseBatch(float* re, float* im, float* out) const {
+			inverseImpl<kLanes>(re, im, out);
+		}
+	}
+}
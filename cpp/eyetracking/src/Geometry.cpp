@@ -0,0 +1,101 @@
+#include "Geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace vision {
+	namespace geometry {
+		// Below this many points the pairwise loop beats sorting for the hull
+		static const size_t kPairwiseMax = 16;
+
+		static inline int64_t squaredDistance(const cv::Point& a, const cv::Point& b) {
+			const int64_t dx = (int64_t)a.x - b.x;
+			const int64_t dy = (int64_t)a.y - b.y;
+			return dx * dx + dy * dy;
+		}
+
+		// Twice the signed area of triangle (o, a, b)
+		static inline int64_t cross(const cv::Point& o, const cv::Point& a, const cv::Point& b) {
+			return ((int64_t)a.x - o.x) * ((int64_t)b.y - o.y) - ((int64_t)a.y - o.y) * ((int64_t)b.x - o.x);
+		}
+
+		static int64_t pairwiseSquaredDiameter(const cv::Point* p, size_t n) {
+			int64_t best = 0;
+			for (size_t i = 0; i < n; i++)
+				for (size_t j = i + 1; j < n; j++)
+					best = std::max(best, squaredDistance(p[i], p[j]));
+			return best;
+		}
+
+		// h is a convex polygon in order without collinear vertices
+		static int64_t caliperSquaredDiameter(const cv::Point* h, size_t n) {
+			if (n <= 3)
+				return pairwiseSquaredDiameter(h, n);
+
+			// For each edge (i, i + 1) advance j to the vertex farthest from it;
+			// the farthest pairs are among these antipodal (edge, vertex) pairs
+			int64_t best = 0;
+			size_t j = 1;
+			for (size_t i = 0; i < n; i++) {
+				const size_t next = i + 1 == n ? 0 : i + 1;
+				for (;;) {
+					const size_t k = j + 1 == n ? 0 : j + 1;
+					if (std::abs(cross(h[i], h[next], h[k])) <= std::abs(cross(h[i], h[next], h[j])))
+						break;
+					j = k;
+				}
+				best = std::max(best, std::max(squaredDistance(h[i], h[j]), squaredDistance(h[next], h[j])));
+			}
+			return best;
+		}
+
+		int64_t squaredDiameter(const std::vector<cv::Point>& points) {
+			if (points.size() <= kPairwiseMax)
+				return pairwiseSquaredDiameter(points.data(), points.size());
+
+			thread_local std::vector<cv::Point> sorted, hull;
+			sorted.assign(points.begin(), points.end());
+			std::sort(sorted.begin(), sorted.end(), [](const cv::Point& a, const cv::Point& b) {
+				return a.x < b.x || (a.x == b.x && a.y < b.y);
+			});
+			sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+			// Monotone chain, collinear points dropped: lower hull, then upper
+			const size_t n = sorted.size();
+			hull.resize(2 * n);
+			size_t k = 0;
+			for (size_t i = 0; i < n; i++) {
+				while (k >= 2 && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0)
+					k--;
+				hull[k++] = sorted[i];
+			}
+			for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+				while (k >= lower && cross(hull[k - 2], hull[k - 1], sorted[i]) <= 0)
+					k--;
+				hull[k++] = sorted[i];
+			}
+			if (k > 1)
+				k--; // last point repeats the first
+
+			return caliperSquaredDiameter(hull.data(), k);
+		}
+
+		float diameter(const std::vector<cv::Point>& points) {
+			return (float)std::sqrt((double)squaredDiameter(points));
+		}
+
+		bool boundingBoxExceeds(const std::vector<cv::Point>& points, double limit) {
+			if (points.empty())
+				return false;
+			int minX = points[0].x, maxX = minX;
+			int minY = points[0].y, maxY = minY;
+			for (const cv::Point& p : points) {
+				minX = std::min(minX, p.x);
+				maxX = std::max(maxX, p.x);
+				minY = std::min(minY, p.y);
+				maxY = std::max(maxY, p.y);
+			}
+			return std::max(maxX - minX, maxY - minY) >= limit;
+		}
+	}
+}
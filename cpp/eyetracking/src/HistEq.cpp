@@ -1,70 +1,217 @@
 #include "Histeq.h"
 #include "Utils.h"
+#include "Simd.h"
 #include <algorithm>
-#include <numeric>
 #include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace vision {
 	namespace histeq {
+        // Rows/tiles are only split across threads above this many pixels
+        static const int kParallelMinPixels = 320 * 240;
+
+        // Bilinear weights between tile LUTs, Q11 per axis
+        static const int kWeightBits = 11;
+        static const int kWeightOne = 1 << kWeightBits;
+
+        static const int kBins = 256;
+
+        // Tile layout: ceil-sized tiles, the last row/column may be shorter
+        struct TileGrid {
+            TileGrid(cv::Size imageSize, cv::Size grid);
+            cv::Rect tile(int tx, int ty) const;
+
+            int nx, ny;
+            int tileWidth, tileHeight;
+            int width, height;
+        };
 
         //------------------------------------------------------
         // Helper: clip histogram to limit contrast enhancement
         //------------------------------------------------------
-        static void clipHistogram(std::vector<int>& hist, int clipLimit)
+        static void clipHistogram(int* hist, int clipLimit)
         {
             // compute total excess pixels above clip limit
             int excess = 0;
-            for (int& h : hist) {
-                if (h > clipLimit) {
-                    excess += (h - clipLimit);
-                    h = clipLimit;
+            for (int i = 0; i < kBins; ++i) {
+                if (hist[i] > clipLimit) {
+                    excess += (hist[i] - clipLimit);
+                    hist[i] = clipLimit;
                 }
             }
 
             // redistribute excess pixels equally
-            int bins = static_cast<int>(hist.size());
-            int distribute = excess / bins;
-            int remainder = excess % bins;
+            int distribute = excess / kBins;
+            int remainder = excess % kBins;
 
-            for (int& h : hist)
-                h += distribute;
+            for (int i = 0; i < kBins; ++i)
+                hist[i] += distribute;
 
             // distribute the remaining pixels one by one
-            for (int i = 0; remainder > 0; ++i, --remainder)
-                hist[i % bins]++;
+            for (int i = 0; i < remainder; ++i)
+                hist[i]++;
         }
 
         //------------------------------------------------------
-        // Helper: compute cumulative distribution (CDF)
+        // Helper: histogram of one tile (or of every rowStep-th row from rowOffset)
+        // Four banks so runs of equal pixels (flat eye regions) do not serialize
+        // on a store-to-load dependency through the same counter.
         //------------------------------------------------------
-        static std::vector<uchar> makeLUT(const std::vector<int>& hist, int totalPixels)
+        static void tileHistogram(const cv::Mat& src, cv::Rect tile, int* hist, int rowOffset = 0, int rowStep = 1)
         {
-            std::vector<uchar> lut(hist.size(), 0);
-            std::vector<int> cdf(hist.size(), 0);
+            int banks[4][kBins];
+            std::memset(banks, 0, sizeof(banks));
+            for (int y = tile.y + rowOffset; y < tile.y + tile.height; y += rowStep) {
+                const uchar* row = src.ptr<uchar>(y) + tile.x;
+                int x = 0;
+                for (; x <= tile.width - 4; x += 4) {
+                    banks[0][row[x]]++;
+                    banks[1][row[x + 1]]++;
+                    banks[2][row[x + 2]]++;
+                    banks[3][row[x + 3]]++;
+                }
+                for (; x < tile.width; ++x)
+                    banks[0][row[x]]++;
+            }
+            for (int i = 0; i < kBins; ++i)
+                hist[i] = banks[0][i] + banks[1][i] + banks[2][i] + banks[3][i];
+        }
 
-            // build cumulative histogram
-            std::partial_sum(hist.begin(), hist.end(), cdf.begin());
+        //------------------------------------------------------
+        // Helper: clip a tile histogram (in place) and turn its CDF into a LUT
+        //------------------------------------------------------
+        static void tileLut(int* hist, int totalPixels, double clipLimit, uchar* lut)
+        {
+            if (totalPixels <= 0) {
+                for (int i = 0; i < kBins; ++i)
+                    lut[i] = static_cast<uchar>(i);
+                return;
+            }
 
-            // normalize to [0, 255]
+            // clip limit calculation: proportional to tile size
+            int limit = std::max(1, static_cast<int>(clipLimit * totalPixels / 256.0));
+            clipHistogram(hist, limit);
+
+            // normalize the cumulative histogram to [0, 255]
             double scale = 255.0 / totalPixels;
-            for (size_t i = 0; i < cdf.size(); ++i)
-                lut[i] = static_cast<uchar>(clamp(int(cdf[i] * scale), 0, 255));
+            int cdf = 0;
+            for (int i = 0; i < kBins; ++i) {
+                cdf += hist[i];
+                lut[i] = static_cast<uchar>(clamp(int(cdf * scale), 0, 255));
+            }
+        }
+
+        TileGrid::TileGrid(cv::Size imageSize, cv::Size grid)
+            : nx(grid.width), ny(grid.height)
+        {
+            CV_Assert(nx > 0 && ny > 0);
+            tileWidth = std::max(1, (int)std::ceil((float)imageSize.width / nx));
+            tileHeight = std::max(1, (int)std::ceil((float)imageSize.height / ny));
+            width = imageSize.width;
+            height = imageSize.height;
+        }
 
-            return lut;
+        cv::Rect TileGrid::tile(int tx, int ty) const
+        {
+            // with ceil-sized tiles the last ones can be short or even empty
+            int x0 = std::min(tx * tileWidth, width);
+            int y0 = std::min(ty * tileHeight, height);
+            int x1 = std::min(x0 + tileWidth, width);
+            int y1 = std::min(y0 + tileHeight, height);
+            return cv::Rect(x0, y0, x1 - x0, y1 - y0);
         }
 
         //------------------------------------------------------
-        // Helper: compute histogram for a tile
+        // Helper: neighbouring tiles and Q11 weight along one axis.
+        // Positions before the first / after the last tile centre use that tile
+        // alone.
         //------------------------------------------------------
-        static std::vector<int> computeHistogram(const cv::Mat& tile)
+        static void axisWeights(int pos, int tileSize, int tiles, int& t1, int& t2, int& w)
         {
-            std::vector<int> hist(256, 0);
-            for (int y = 0; y < tile.rows; ++y) {
-                const uchar* row = tile.ptr<uchar>(y);
-                for (int x = 0; x < tile.cols; ++x)
-                    hist[row[x]]++;
+            float g = (float)pos / tileSize - 0.5f;
+            int lo = int(std::floor(g));
+            w = cvRound((g - lo) * kWeightOne);
+            t1 = clamp(lo, 0, tiles - 1);
+            t2 = clamp(lo + 1, 0, tiles - 1);
+            if (t1 == t2)
+                w = 0;
+        }
+
+        // top * (1 - w) + bottom * w for a whole row of tile LUTs, Q11.
+        // Done once per image row so the per-pixel blend needs two lookups, not four.
+        static void blendLutRows(const uchar* __restrict top, const uchar* __restrict bottom,
+            int* __restrict out, int count, int w)
+        {
+            const int wTop = kWeightOne - w;
+            int i = 0;
+#if defined(VISION_SIMD_SSE2)
+            // (top, bottom) byte pairs widened to 16 bits and weighted with one madd
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i weights = _mm_set1_epi32((w << 16) | wTop);
+            for (; i <= count - 16; i += 16) {
+                __m128i t = _mm_loadu_si128((const __m128i*)(top + i));
+                __m128i b = _mm_loadu_si128((const __m128i*)(bottom + i));
+                __m128i lo = _mm_unpacklo_epi8(t, b);
+                __m128i hi = _mm_unpackhi_epi8(t, b);
+                _mm_storeu_si128((__m128i*)(out + i), _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weights));
+                _mm_storeu_si128((__m128i*)(out + i + 4), _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weights));
+                _mm_storeu_si128((__m128i*)(out + i + 8), _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weights));
+                _mm_storeu_si128((__m128i*)(out + i + 12), _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weights));
+            }
+#endif
+            for (; i < count; ++i)
+                out[i] = top[i] * wTop + bottom[i] * w;
+        }
+
+        // Horizontal half of the blend on a pre-blended LUT row. s and d may be
+        // the same row (dst aliasing src), so they are not __restrict
+        static void blendRow(const uchar* s, uchar* d, const int* __restrict m,
+            const int* __restrict cl, const int* __restrict cr, const int* __restrict cw, int cols)
+        {
+            for (int x = 0; x < cols; ++x) {
+                const int v = s[x];
+                const int wx = cw[x];
+                // m is <= 255 << 11, so the weighted pair fits 31 bits
+                d[x] = static_cast<uchar>((m[cl[x] + v] * (kWeightOne - wx) + m[cr[x] + v] * wx
+                    + (1 << (2 * kWeightBits - 1))) >> (2 * kWeightBits));
+            }
+        }
+
+        //------------------------------------------------------
+        // Bilinear blend of the four surrounding tile LUTs per pixel
+        //------------------------------------------------------
+        static void applyTileLuts(const cv::Mat& src, cv::Mat& dst, const TileGrid& grid, const uchar* luts)
+        {
+            const int rows = src.rows;
+            const int cols = src.cols;
+
+            // per column: LUT offsets of the left/right tile and the right weight
+            std::vector<int> colLeft(cols), colRight(cols), colWeight(cols);
+            for (int x = 0; x < cols; ++x) {
+                int t1, t2, w;
+                axisWeights(x, grid.tileWidth, grid.nx, t1, t2, w);
+                colLeft[x] = t1 * kBins;
+                colRight[x] = t2 * kBins;
+                colWeight[x] = w;
+            }
+            const int* cl = colLeft.data();
+            const int* cr = colRight.data();
+            const int* cw = colWeight.data();
+
+#pragma omp parallel if (rows * cols >= kParallelMinPixels)
+            {
+                // the two tile rows of the current image row, pre-blended vertically (Q11)
+                std::vector<int> mixed((size_t)grid.nx * kBins);
+#pragma omp for schedule(static)
+                for (int y = 0; y < rows; ++y) {
+                    int t1, t2, wy;
+                    axisWeights(y, grid.tileHeight, grid.ny, t1, t2, wy);
+                    blendLutRows(luts + (size_t)t1 * grid.nx * kBins, luts + (size_t)t2 * grid.nx * kBins,
+                        mixed.data(), grid.nx * kBins, wy);
+                    blendRow(src.ptr<uchar>(y), dst.ptr<uchar>(y), mixed.data(), cl, cr, cw, cols);
+                }
             }
-            return hist;
         }
 
         //------------------------------------------------------
@@ -74,74 +221,142 @@ namespace vision {
         {
             CV_Assert(src.type() == CV_8UC1);
 
-            dst.create(src.size(), src.type());
+            const TileGrid grid(src.size(), tileGridSize);
+            const int tiles = grid.nx * grid.ny;
 
-            const int nx = tileGridSize.width;
-            const int ny = tileGridSize.height;
-            const int tileWidth = std::ceil((float)src.cols / nx);
-            const int tileHeight = std::ceil((float)src.rows / ny);
-
-            // build LUT for each tile
-            std::vector<std::vector<uchar>> luts(nx * ny);
-            for (int ty = 0; ty < ny; ++ty) {
-                for (int tx = 0; tx < nx; ++tx) {
-                    // region boundaries
-                    int x0 = tx * tileWidth;
-                    int y0 = ty * tileHeight;
-                    int x1 = std::min(x0 + tileWidth, src.cols);
-                    int y1 = std::min(y0 + tileHeight, src.rows);
-
-                    // extract tile
-                    cv::Rect roi(x0, y0, x1 - x0, y1 - y0);
-                    cv::Mat tile = src(roi);
-
-                    // histogram and clipping
-                    std::vector<int> hist = computeHistogram(tile);
-
-                    // clip limit calculation: proportional to tile size
-                    int limit = std::max(1, static_cast<int>(clipLimit * tile.total() / 256.0));
-                    clipHistogram(hist, limit);
-
-                    // make LUT from clipped histogram
-                    luts[ty * nx + tx] = makeLUT(hist, tile.total());
-                }
+            // all tile LUTs back to back, tile (tx, ty) at (ty * nx + tx) * 256
+            std::vector<uchar> luts((size_t)tiles * kBins);
+#pragma omp parallel for schedule(static) if (src.rows * src.cols >= kParallelMinPixels)
+            for (int i = 0; i < tiles; ++i) {
+                cv::Rect r = grid.tile(i % grid.nx, i / grid.nx);
+                int hist[kBins];
+                tileHistogram(src, r, hist);
+                tileLut(hist, r.area(), clipLimit, luts.data() + (size_t)i * kBins);
             }
 
-            // interpolation between 4 nearest LUTs (bilinear)
-            for (int y = 0; y < src.rows; ++y) {
-                float gy = (float)y / tileHeight - 0.5f;
-                int y1 = clamp(int(std::floor(gy)), 0, ny - 1);
-                int y2 = clamp(y1 + 1, 0, ny - 1);
-                float dy = gy - y1;
-
-                for (int x = 0; x < src.cols; ++x) {
-                    float gx = (float)x / tileWidth - 0.5f;
-                    int x1 = clamp(int(std::floor(gx)), 0, nx - 1);
-                    int x2 = clamp(x1 + 1, 0, nx - 1);
-                    float dx = gx - x1;
-
-                    // pixel intensity
-                    int val = src.at<uchar>(y, x);
-
-                    // fetch from 4 LUTs and interpolate
-                    uchar lu = luts[y1 * nx + x1][val];
-                    uchar ru = luts[y1 * nx + x2][val];
-                    uchar lb = luts[y2 * nx + x1][val];
-                    uchar rb = luts[y2 * nx + x2][val];
-
-                    // bilinear interpolation
-                    float top = lu + dx * (ru - lu);
-                    float bottom = lb + dx * (rb - lb);
-                    float result = top + dy * (bottom - top);
-
-                    dst.at<uchar>(y, x) = static_cast<uchar>(clamp(int(result), 0, 255));
-                }
-            }
+            // dst may alias src: every pixel is read before it is written, and
+            // only by its own row
+            dst.create(src.size(), src.type());
+            applyTileLuts(src, dst, grid, luts.data());
         }
         cv::Mat CLAHE(const cv::Mat& src, double clipLimit, cv::Size tileGridSize) {
             cv::Mat dst;
             CLAHE(src, dst, clipLimit, tileGridSize);
             return dst;
         }
+
+        //------------------------------------------------------
+        // TemporalCLAHE
+        //------------------------------------------------------
+        // Change detection looks at every kSampleStep-th row through kCoarseBins
+        // bins, which keeps sensor noise well below the default threshold
+        static const int kSampleStep = 4;
+        static const int kCoarseBins = 32;
+
+        TemporalCLAHE::TemporalCLAHE(double clipLimit, cv::Size tileGridSize, double rebuildThreshold, double lutBlend)
+            : clipLimit(clipLimit)
+            , tileGridSize(tileGridSize)
+            , rebuildThreshold(rebuildThreshold)
+            , blendWeight(clamp(cvRound(lutBlend * 256), 0, 255))
+            , rebuilt(0)
+        {
+            CV_Assert(tileGridSize.width > 0 && tileGridSize.height > 0);
+        }
+
+        void TemporalCLAHE::reset()
+        {
+            imageSize = cv::Size();
+            refHist.clear();
+            target.clear();
+            state.clear();
+            luts.clear();
+            settling.clear();
+        }
+
+        void TemporalCLAHE::apply(const cv::Mat& src, cv::Mat& dst)
+        {
+            CV_Assert(src.type() == CV_8UC1);
+
+            const TileGrid grid(src.size(), tileGridSize);
+            const int tiles = grid.nx * grid.ny;
+            // New geometry: every tile is rebuilt and switches without blending
+            const bool fresh = src.size() != imageSize || (int)settling.size() != tiles;
+            if (fresh) {
+                imageSize = src.size();
+                refHist.assign((size_t)tiles * kCoarseBins, 0);
+                target.assign((size_t)tiles * kBins, 0);
+                state.assign((size_t)tiles * kBins, 0);
+                luts.assign((size_t)tiles * kBins, 0);
+                settling.assign(tiles, 0);
+            }
+
+            int rebuiltCount = 0;
+#pragma omp parallel for schedule(static) reduction(+:rebuiltCount) if (src.rows * src.cols >= kParallelMinPixels)
+            for (int i = 0; i < tiles; ++i) {
+                const cv::Rect r = grid.tile(i % grid.nx, i / grid.nx);
+                int* ref = refHist.data() + (size_t)i * kCoarseBins;
+                uchar* tgt = target.data() + (size_t)i * kBins;
+                uint16_t* st = state.data() + (size_t)i * kBins;
+                uchar* lut = luts.data() + (size_t)i * kBins;
+
+                int hist[kBins];
+                tileHistogram(src, r, hist, 0, kSampleStep);
+                int coarse[kCoarseBins] = { 0 };
+                int sampled = 0;
+                for (int b = 0; b < kBins; ++b) {
+                    coarse[b >> 3] += hist[b];
+                    sampled += hist[b];
+                }
+
+                bool rebuild = fresh;
+                if (!rebuild) {
+                    // L1 distance as a fraction of the sampled pixels, 0..1
+                    int dist = 0;
+                    for (int b = 0; b < kCoarseBins; ++b)
+                        dist += std::abs(coarse[b] - ref[b]);
+                    rebuild = sampled > 0 && dist > rebuildThreshold * 2.0 * sampled;
+                }
+
+                if (rebuild) {
+                    std::copy(coarse, coarse + kCoarseBins, ref);
+                    // the sampled rows are already counted, add the rest
+                    int rest[kBins];
+                    for (int o = 1; o < kSampleStep; ++o) {
+                        tileHistogram(src, r, rest, o, kSampleStep);
+                        for (int b = 0; b < kBins; ++b)
+                            hist[b] += rest[b];
+                    }
+                    tileLut(hist, r.area(), clipLimit, tgt);
+                    if (fresh || blendWeight == 0) {
+                        for (int b = 0; b < kBins; ++b)
+                            st[b] = static_cast<uint16_t>(tgt[b] << 8);
+                        std::copy(tgt, tgt + kBins, lut);
+                        settling[i] = 0;
+                    }
+                    else {
+                        settling[i] = 1;
+                    }
+                    ++rebuiltCount;
+                }
+
+                // Exponential approach of the applied LUT (Q8) to the latest target
+                if (settling[i]) {
+                    bool done = true;
+                    for (int b = 0; b < kBins; ++b) {
+                        int goal = tgt[b] << 8;
+                        int v = (st[b] * blendWeight + goal * (256 - blendWeight) + 128) >> 8;
+                        if (std::abs(v - goal) < 128) v = goal;
+                        else done = false;
+                        st[b] = static_cast<uint16_t>(v);
+                        lut[b] = static_cast<uchar>((v + 128) >> 8);
+                    }
+                    settling[i] = done ? 0 : 1;
+                }
+            }
+            rebuilt = rebuiltCount;
+
+            dst.create(src.size(), src.type());
+            applyTileLuts(src, dst, grid, luts.data());
+        }
 	}
-}
\ No newline at end of file
+}
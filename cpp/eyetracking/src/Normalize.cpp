@@ -1,10 +1,15 @@
 #include "Normalize.h"
+#include "Simd.h"
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 
 namespace vision {
     namespace normalize {
+        // Reductions and remaps are only split across threads above this many elements
+        static const int kParallelMinElems = 320 * 240;
+
         // Helper: set default alpha/beta
         static void setAlphaBeta(const cv::Mat& src, double& alpha, double& beta, int norm_type)
         {
@@ -25,75 +30,420 @@ namespace vision {
             }
         }
 
-        // Internal template function
+        // ------------------------------------------------------------------
+        // Row reductions. The generic versions are plain loops; the common
+        // depths get SSE2 versions.
+        // ------------------------------------------------------------------
         template<typename T>
-        static void normalizeImpl(const cv::Mat& src,
-            cv::Mat& dst,
-            double alpha,
-            double beta,
-            int norm_type)
+        static void rowMinMax(const T* p, int n, T& mn, T& mx)
         {
-            dst.create(src.size(), src.type());
+            for (int j = 0; j < n; ++j) {
+                mn = std::min(mn, p[j]);
+                mx = std::max(mx, p[j]);
+            }
+        }
 
-            double minVal = 0, maxVal = 0, sum = 0, sumSq = 0;
+        template<typename T>
+        static double rowAbsSum(const T* p, int n)
+        {
+            double s = 0;
+            for (int j = 0; j < n; ++j)
+                s += std::abs(static_cast<double>(p[j]));
+            return s;
+        }
 
-            if (norm_type == NORM_MINMAX) {
-                cv::minMaxLoc(src, &minVal, &maxVal);
-                if (std::abs(maxVal - minVal) < std::numeric_limits<double>::epsilon()) {
-                    dst.setTo(cv::Scalar(alpha));
-                    return;
+        template<typename T>
+        static double rowSqSum(const T* p, int n)
+        {
+            double s = 0;
+            for (int j = 0; j < n; ++j) {
+                double v = static_cast<double>(p[j]);
+                s += v * v;
+            }
+            return s;
+        }
+
+#if defined(VISION_SIMD_SSE2)
+        template<>
+        void rowMinMax<uchar>(const uchar* p, int n, uchar& mn, uchar& mx)
+        {
+            int j = 0;
+            if (n >= 16) {
+                __m128i vmin = _mm_set1_epi8((char)mn), vmax = _mm_set1_epi8((char)mx);
+                for (; j <= n - 16; j += 16) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+                    vmin = _mm_min_epu8(vmin, v);
+                    vmax = _mm_max_epu8(vmax, v);
+                }
+                alignas(16) uchar bufMin[16], bufMax[16];
+                _mm_store_si128((__m128i*)bufMin, vmin);
+                _mm_store_si128((__m128i*)bufMax, vmax);
+                for (int k = 0; k < 16; ++k) {
+                    mn = std::min(mn, bufMin[k]);
+                    mx = std::max(mx, bufMax[k]);
                 }
             }
-            else if (norm_type == NORM_INF) {
-                maxVal = 0;
-                for (int i = 0; i < src.rows; i++) {
-                    const T* ptr = src.ptr<T>(i);
-                    for (int j = 0; j < src.cols * src.channels(); j++)
-                        maxVal = std::max(maxVal, std::abs(static_cast<double>(ptr[j])));
+            for (; j < n; ++j) {
+                mn = std::min(mn, p[j]);
+                mx = std::max(mx, p[j]);
+            }
+        }
+
+        template<>
+        void rowMinMax<short>(const short* p, int n, short& mn, short& mx)
+        {
+            int j = 0;
+            if (n >= 8) {
+                __m128i vmin = _mm_set1_epi16(mn), vmax = _mm_set1_epi16(mx);
+                for (; j <= n - 8; j += 8) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+                    vmin = _mm_min_epi16(vmin, v);
+                    vmax = _mm_max_epi16(vmax, v);
                 }
-                if (maxVal < std::numeric_limits<double>::epsilon()) {
-                    dst.setTo(cv::Scalar(0));
-                    return;
+                alignas(16) short bufMin[8], bufMax[8];
+                _mm_store_si128((__m128i*)bufMin, vmin);
+                _mm_store_si128((__m128i*)bufMax, vmax);
+                for (int k = 0; k < 8; ++k) {
+                    mn = std::min(mn, bufMin[k]);
+                    mx = std::max(mx, bufMax[k]);
                 }
             }
-            else if (norm_type == NORM_L1 || norm_type == NORM_L2) {
-                for (int i = 0; i < src.rows; i++) {
-                    const T* ptr = src.ptr<T>(i);
-                    for (int j = 0; j < src.cols * src.channels(); j++) {
-                        double val = static_cast<double>(ptr[j]);
-                        if (norm_type == NORM_L1) sum += std::abs(val);
-                        else sumSq += val * val;
-                    }
+            for (; j < n; ++j) {
+                mn = std::min(mn, p[j]);
+                mx = std::max(mx, p[j]);
+            }
+        }
+
+        template<>
+        void rowMinMax<ushort>(const ushort* p, int n, ushort& mn, ushort& mx)
+        {
+            int j = 0;
+            if (n >= 8) {
+                // SSE2 only has signed 16-bit min/max: flip the sign bit around them
+                const __m128i bias = _mm_set1_epi16((short)0x8000);
+                __m128i vmin = _mm_set1_epi16((short)(mn ^ 0x8000)), vmax = _mm_set1_epi16((short)(mx ^ 0x8000));
+                for (; j <= n - 8; j += 8) {
+                    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + j)), bias);
+                    vmin = _mm_min_epi16(vmin, v);
+                    vmax = _mm_max_epi16(vmax, v);
                 }
-                if ((norm_type == NORM_L1 && sum < std::numeric_limits<double>::epsilon()) ||
-                    (norm_type == NORM_L2 && sumSq < std::numeric_limits<double>::epsilon())) {
-                    dst.setTo(cv::Scalar(0));
-                    return;
+                alignas(16) ushort bufMin[8], bufMax[8];
+                _mm_store_si128((__m128i*)bufMin, _mm_xor_si128(vmin, bias));
+                _mm_store_si128((__m128i*)bufMax, _mm_xor_si128(vmax, bias));
+                for (int k = 0; k < 8; ++k) {
+                    mn = std::min(mn, bufMin[k]);
+                    mx = std::max(mx, bufMax[k]);
                 }
             }
+            for (; j < n; ++j) {
+                mn = std::min(mn, p[j]);
+                mx = std::max(mx, p[j]);
+            }
+        }
+
+        template<>
+        void rowMinMax<float>(const float* p, int n, float& mn, float& mx)
+        {
+            int j = 0;
+            if (n >= 4) {
+                __m128 vmin = _mm_set1_ps(mn), vmax = _mm_set1_ps(mx);
+                for (; j <= n - 4; j += 4) {
+                    __m128 v = _mm_loadu_ps(p + j);
+                    vmin = _mm_min_ps(vmin, v);
+                    vmax = _mm_max_ps(vmax, v);
+                }
+                alignas(16) float bufMin[4], bufMax[4];
+                _mm_store_ps(bufMin, vmin);
+                _mm_store_ps(bufMax, vmax);
+                for (int k = 0; k < 4; ++k) {
+                    mn = std::min(mn, bufMin[k]);
+                    mx = std::max(mx, bufMax[k]);
+                }
+            }
+            for (; j < n; ++j) {
+                mn = std::min(mn, p[j]);
+                mx = std::max(mx, p[j]);
+            }
+        }
 
-            for (int i = 0; i < src.rows; i++) {
+        template<>
+        double rowAbsSum<uchar>(const uchar* p, int n)
+        {
+            int j = 0;
+            uint64_t s = 0;
+            // psadbw against zero sums 8 bytes into each 64-bit half
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+            for (; j <= n - 16; j += 16)
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(p + j)), zero));
+            alignas(16) uint64_t buf[2];
+            _mm_store_si128((__m128i*)buf, acc);
+            s = buf[0] + buf[1];
+            for (; j < n; ++j)
+                s += p[j];
+            return static_cast<double>(s);
+        }
+
+        template<>
+        double rowSqSum<uchar>(const uchar* p, int n)
+        {
+            int j = 0;
+            uint64_t s = 0;
+            const __m128i zero = _mm_setzero_si128();
+            // each int32 lane gains at most 4 * 255^2 per 16 bytes, so flush
+            // to 64 bits every 4096 iterations
+            while (j <= n - 16) {
+                const int end = std::min(n - 15, j + 4096 * 16);
+                __m128i acc = zero;
+                for (; j < end; j += 16) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+                    __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+                    acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+                }
+                alignas(16) uint32_t buf[4];
+                _mm_store_si128((__m128i*)buf, acc);
+                s += (uint64_t)buf[0] + buf[1] + buf[2] + buf[3];
+            }
+            for (; j < n; ++j)
+                s += (uint32_t)p[j] * p[j];
+            return static_cast<double>(s);
+        }
+
+        template<>
+        double rowAbsSum<float>(const float* p, int n)
+        {
+            int j = 0;
+            // accumulate in double like the scalar path
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+            __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+            for (; j <= n - 4; j += 4) {
+                __m128 v = _mm_and_ps(_mm_loadu_ps(p + j), absMask);
+                a0 = _mm_add_pd(a0, _mm_cvtps_pd(v));
+                a1 = _mm_add_pd(a1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+            }
+            alignas(16) double buf[2];
+            _mm_store_pd(buf, _mm_add_pd(a0, a1));
+            double s = buf[0] + buf[1];
+            for (; j < n; ++j)
+                s += std::abs(static_cast<double>(p[j]));
+            return s;
+        }
+
+        template<>
+        double rowSqSum<float>(const float* p, int n)
+        {
+            int j = 0;
+            __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+            for (; j <= n - 4; j += 4) {
+                __m128 v = _mm_loadu_ps(p + j);
+                __m128d lo = _mm_cvtps_pd(v), hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+                a0 = _mm_add_pd(a0, _mm_mul_pd(lo, lo));
+                a1 = _mm_add_pd(a1, _mm_mul_pd(hi, hi));
+            }
+            alignas(16) double buf[2];
+            _mm_store_pd(buf, _mm_add_pd(a0, a1));
+            double s = buf[0] + buf[1];
+            for (; j < n; ++j) {
+                double v = static_cast<double>(p[j]);
+                s += v * v;
+            }
+            return s;
+        }
+#endif
+
+        // ------------------------------------------------------------------
+        // Whole-image reductions, row-parallel for large inputs. Partial results
+        // are merged under a critical section (OpenMP 2.0 has no min/max reduction).
+        // ------------------------------------------------------------------
+        template<typename T>
+        static void imageMinMax(const cv::Mat& src, double& minVal, double& maxVal)
+        {
+            const int rows = src.rows;
+            const int n = src.cols * src.channels();
+            T mn = std::numeric_limits<T>::max();
+            T mx = std::numeric_limits<T>::lowest();
+#pragma omp parallel if ((size_t)rows * n >= (size_t)kParallelMinElems)
+            {
+                T localMin = std::numeric_limits<T>::max();
+                T localMax = std::numeric_limits<T>::lowest();
+#pragma omp for schedule(static)
+                for (int i = 0; i < rows; ++i)
+                    rowMinMax<T>(src.ptr<T>(i), n, localMin, localMax);
+#pragma omp critical(vision_normalize_minmax)
+                {
+                    mn = std::min(mn, localMin);
+                    mx = std::max(mx, localMax);
+                }
+            }
+            minVal = static_cast<double>(mn);
+            maxVal = static_cast<double>(mx);
+        }
+
+        template<typename T, bool Squared>
+        static double imageSum(const cv::Mat& src)
+        {
+            const int rows = src.rows;
+            const int n = src.cols * src.channels();
+            double sum = 0;
+#pragma omp parallel for schedule(static) reduction(+:sum) if ((size_t)rows * n >= (size_t)kParallelMinElems)
+            for (int i = 0; i < rows; ++i)
+                sum += Squared ? rowSqSum<T>(src.ptr<T>(i), n) : rowAbsSum<T>(src.ptr<T>(i), n);
+            return sum;
+        }
+
+        // ------------------------------------------------------------------
+        // Per-norm element mapping, picked at compile time. Each keeps the exact
+        // expression of the original per-element switch.
+        // ------------------------------------------------------------------
+        template<int NormType> struct Mapping;
+
+        template<> struct Mapping<NORM_MINMAX> {
+            double minVal, range, alpha, span;
+            double operator()(double val) const { return (val - minVal) / range * span + alpha; }
+        };
+
+        template<> struct Mapping<NORM_INF> {
+            double maxVal, alpha;
+            double operator()(double val) const { return val / maxVal * alpha; }
+        };
+
+        template<> struct Mapping<NORM_L1> {
+            double sum, alpha;
+            double operator()(double val) const { return val / sum * alpha; }
+        };
+
+        template<> struct Mapping<NORM_L2> {
+            double norm, alpha;
+            double operator()(double val) const { return val / norm * alpha; }
+        };
+
+        // Reduction for one norm; returns false when the input is degenerate
+        // (dst already filled)
+        template<typename T>
+        static bool prepare(const cv::Mat& src, cv::Mat& dst, double alpha, double beta, Mapping<NORM_MINMAX>& m)
+        {
+            double minVal = 0, maxVal = 0;
+            imageMinMax<T>(src, minVal, maxVal);
+            if (std::abs(maxVal - minVal) < std::numeric_limits<double>::epsilon()) {
+                dst.setTo(cv::Scalar(alpha));
+                return false;
+            }
+            m = { minVal, maxVal - minVal, alpha, beta - alpha };
+            return true;
+        }
+
+        template<typename T>
+        static bool prepare(const cv::Mat& src, cv::Mat& dst, double alpha, double, Mapping<NORM_INF>& m)
+        {
+            // max |v| from the min/max pair
+            double minVal = 0, maxVal = 0;
+            imageMinMax<T>(src, minVal, maxVal);
+            double maxAbs = std::max(std::abs(minVal), std::abs(maxVal));
+            if (maxAbs < std::numeric_limits<double>::epsilon()) {
+                dst.setTo(cv::Scalar(0));
+                return false;
+            }
+            m = { maxAbs, alpha };
+            return true;
+        }
+
+        template<typename T>
+        static bool prepare(const cv::Mat& src, cv::Mat& dst, double alpha, double, Mapping<NORM_L1>& m)
+        {
+            double sum = imageSum<T, false>(src);
+            if (sum < std::numeric_limits<double>::epsilon()) {
+                dst.setTo(cv::Scalar(0));
+                return false;
+            }
+            m = { sum, alpha };
+            return true;
+        }
+
+        template<typename T>
+        static bool prepare(const cv::Mat& src, cv::Mat& dst, double alpha, double, Mapping<NORM_L2>& m)
+        {
+            double sumSq = imageSum<T, true>(src);
+            if (sumSq < std::numeric_limits<double>::epsilon()) {
+                dst.setTo(cv::Scalar(0));
+                return false;
+            }
+            m = { std::sqrt(sumSq), alpha };
+            return true;
+        }
+
+        // Internal template function
+        template<typename T, int NormType>
+        static void normalizeImpl(const cv::Mat& src,
+            cv::Mat& dst,
+            double alpha,
+            double beta)
+        {
+            dst.create(src.size(), src.type());
+
+            Mapping<NormType> map;
+            if (!prepare<T>(src, dst, alpha, beta, map))
+                return;
+
+            const int rows = src.rows;
+            const int n = src.cols * src.channels();
+#pragma omp parallel for schedule(static) if ((size_t)rows * n >= (size_t)kParallelMinElems)
+            for (int i = 0; i < rows; i++) {
                 const T* srcPtr = src.ptr<T>(i);
                 T* dstPtr = dst.ptr<T>(i);
-                for (int j = 0; j < src.cols * src.channels(); j++) {
-                    double val = static_cast<double>(srcPtr[j]);
-                    double normVal = 0.0;
-                    switch (norm_type) {
-                    case NORM_MINMAX:
-                        normVal = (val - minVal) / (maxVal - minVal) * (beta - alpha) + alpha;
-                        break;
-                    case NORM_INF:
-                        normVal = val / maxVal * alpha;
-                        break;
-                    case NORM_L1:
-                        normVal = val / sum * alpha;
-                        break;
-                    case NORM_L2:
-                        normVal = val / std::sqrt(sumSq) * alpha;
-                        break;
-                    }
-                    dstPtr[j] = static_cast<T>(normVal);
-                }
+                for (int j = 0; j < n; j++)
+                    dstPtr[j] = static_cast<T>(map(static_cast<double>(srcPtr[j])));
+            }
+        }
+
+        // 8-bit inputs only have 256 distinct values: map them once into a LUT
+        template<int NormType>
+        static void normalizeLut8u(const cv::Mat& src,
+            cv::Mat& dst,
+            double alpha,
+            double beta)
+        {
+            dst.create(src.size(), src.type());
+
+            Mapping<NormType> map;
+            if (!prepare<uchar>(src, dst, alpha, beta, map))
+                return;
+
+            uchar lut[256];
+            for (int v = 0; v < 256; ++v)
+                lut[v] = static_cast<uchar>(map(static_cast<double>(v)));
+
+            const int rows = src.rows;
+            const int n = src.cols * src.channels();
+#pragma omp parallel for schedule(static) if ((size_t)rows * n >= (size_t)kParallelMinElems)
+            for (int i = 0; i < rows; i++) {
+                const uchar* srcPtr = src.ptr<uchar>(i);
+                uchar* dstPtr = dst.ptr<uchar>(i);
+                for (int j = 0; j < n; j++)
+                    dstPtr[j] = lut[srcPtr[j]];
+            }
+        }
+
+        template<typename T>
+        static void normalizeDepth(const cv::Mat& src, cv::Mat& dst, double alpha, double beta, int norm_type)
+        {
+            switch (norm_type) {
+            case NORM_MINMAX: normalizeImpl<T, NORM_MINMAX>(src, dst, alpha, beta); break;
+            case NORM_INF:    normalizeImpl<T, NORM_INF>(src, dst, alpha, beta); break;
+            case NORM_L1:     normalizeImpl<T, NORM_L1>(src, dst, alpha, beta); break;
+            case NORM_L2:     normalizeImpl<T, NORM_L2>(src, dst, alpha, beta); break;
+            default: CV_Error(cv::Error::StsBadArg, "Unsupported norm type");
+            }
+        }
+
+        template<>
+        void normalizeDepth<uchar>(const cv::Mat& src, cv::Mat& dst, double alpha, double beta, int norm_type)
+        {
+            switch (norm_type) {
+            case NORM_MINMAX: normalizeLut8u<NORM_MINMAX>(src, dst, alpha, beta); break;
+            case NORM_INF:    normalizeLut8u<NORM_INF>(src, dst, alpha, beta); break;
+            case NORM_L1:     normalizeLut8u<NORM_L1>(src, dst, alpha, beta); break;
+            case NORM_L2:     normalizeLut8u<NORM_L2>(src, dst, alpha, beta); break;
+            default: CV_Error(cv::Error::StsBadArg, "Unsupported norm type");
             }
         }
 
@@ -108,12 +458,12 @@ namespace vision {
             setAlphaBeta(src, alpha, beta, norm_type);
 
             switch (src.depth()) {
-            case CV_8U:  normalizeImpl<uchar>(src, dst, alpha, beta, norm_type); break;
-            case CV_16U: normalizeImpl<unsigned short>(src, dst, alpha, beta, norm_type); break;
-            case CV_16S: normalizeImpl<short>(src, dst, alpha, beta, norm_type); break;
-            case CV_32S: normalizeImpl<int>(src, dst, alpha, beta, norm_type); break;
-            case CV_32F: normalizeImpl<float>(src, dst, alpha, beta, norm_type); break;
-            case CV_64F: normalizeImpl<double>(src, dst, alpha, beta, norm_type); break;
+            case CV_8U:  normalizeDepth<uchar>(src, dst, alpha, beta, norm_type); break;
+            case CV_16U: normalizeDepth<unsigned short>(src, dst, alpha, beta, norm_type); break;
+            case CV_16S: normalizeDepth<short>(src, dst, alpha, beta, norm_type); break;
+            case CV_32S: normalizeDepth<int>(src, dst, alpha, beta, norm_type); break;
+            case CV_32F: normalizeDepth<float>(src, dst, alpha, beta, norm_type); break;
+            case CV_64F: normalizeDepth<double>(src, dst, alpha, beta, norm_type); break;
             default: CV_Error(cv::Error::StsUnsupportedFormat, "Unsupported Mat depth");
             }
         }
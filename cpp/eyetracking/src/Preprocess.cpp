@@ -60,6 +60,24 @@ namespace vision {
 			cv::Mat u = unsharpMask(c, unsharpAmount, unsharpSigma);
 			return u;
 		}
+
+		cv::Mat enhanceForPupil(const cv::Mat& gray,
+			vision::histeq::TemporalCLAHE& clahe,
+			int bilateralDiameter,
+			double sigmaColor,
+			double sigmaSpace,
+			double unsharpAmount,
+			double unsharpSigma)
+		{
+			cv::Mat g;
+			if (gray.channels() == 3) cv::cvtColor(gray, g, cv::COLOR_BGR2GRAY);
+			else g = gray;
+			cv::Mat d = denoise(g, bilateralDiameter, sigmaColor, sigmaSpace);
+			cv::Mat c;
+			clahe.apply(d, c);
+			cv::Mat u = unsharpMask(c, unsharpAmount, unsharpSigma);
+			return u;
+		}
 	}
 }
 
@@ -0,0 +1,136 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+namespace vision {
+	namespace profile {
+		const char* stageName(Stage stage) {
+			switch (stage) {
+			case Stage::Total: return "total";
+			case Stage::Resize: return "resize";
+			case Stage::Flip: return "flip";
+			case Stage::CvtColor: return "cvt_color";
+			case Stage::Haar: return "haar";
+			case Stage::RoiResize: return "roi_resize";
+			case Stage::Morphology: return "morphology";
+			case Stage::Enhance: return "enhance";
+			case Stage::Detect: return "detect";
+			case Stage::Validate: return "validate";
+			case Stage::Smooth: return "smooth";
+			default: return "unknown";
+			}
+		}
+
+		double LatencyHistogram::bucketLower(int b) {
+			return std::ldexp(1.0 + (double)(b % kSubBuckets) / kSubBuckets, kMinLog2 + b / kSubBuckets);
+		}
+
+		double LatencyHistogram::bucketUpper(int b) {
+			return (b + 1 < kBuckets) ? bucketLower(b + 1) : std::ldexp(1.0, kMaxLog2);
+		}
+
+		void LatencyHistogram::record(uint64_t ns) {
+			int b = 0;
+			if (ns >= (1ull << kMinLog2)) {
+				// Octave from the highest set bit, sub-bucket from the next two bits
+				int msb = 63;
+				while (!(ns >> msb)) --msb;
+				int sub = (int)((ns >> (msb - 2)) & (kSubBuckets - 1));
+				b = (msb - kMinLog2) * kSubBuckets + sub;
+				if (b >= kBuckets) b = kBuckets - 1;
+			}
+			buckets[b].fetch_add(1, std::memory_order_relaxed);
+			total.fetch_add(1, std::memory_order_relaxed);
+			sumNs.fetch_add(ns, std::memory_order_relaxed);
+
+			uint64_t cur = minNs.load(std::memory_order_relaxed);
+			while (ns < cur && !minNs.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+			cur = maxNs.load(std::memory_order_relaxed);
+			while (ns > cur && !maxNs.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+		}
+
+		void LatencyHistogram::reset() {
+			for (int b = 0; b < kBuckets; ++b) buckets[b].store(0, std::memory_order_relaxed);
+			total.store(0, std::memory_order_relaxed);
+			sumNs.store(0, std::memory_order_relaxed);
+			minNs.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+			maxNs.store(0, std::memory_order_relaxed);
+		}
+
+		double LatencyHistogram::meanMs() const {
+			uint64_t n = count();
+			return n ? (double)sumNs.load(std::memory_order_relaxed) / n * 1e-6 : 0.0;
+		}
+
+		double LatencyHistogram::minMs() const {
+			return count() ? minNs.load(std::memory_order_relaxed) * 1e-6 : 0.0;
+		}
+
+		double LatencyHistogram::maxMs() const {
+			return maxNs.load(std::memory_order_relaxed) * 1e-6;
+		}
+
+		double LatencyHistogram::percentileMs(double p) const {
+			uint64_t n = count();
+			if (n == 0) return 0.0;
+			double target = std::min(std::max(p, 0.0), 100.0) / 100.0 * n;
+			uint64_t acc = 0;
+			for (int b = 0; b < kBuckets; ++b) {
+				uint64_t c = buckets[b].load(std::memory_order_relaxed);
+				if (c == 0) continue;
+				if (acc + c >= target) {
+					double lo = (b == 0) ? 0.0 : bucketLower(b);
+					double hi = bucketUpper(b);
+					double t = (target - acc) / c;
+					double ns = lo + (hi - lo) * t;
+					// Never report outside the observed range
+					ns = std::min(std::max(ns, (double)minNs.load(std::memory_order_relaxed)), (double)maxNs.load(std::memory_order_relaxed));
+					return ns * 1e-6;
+				}
+				acc += c;
+			}
+			return maxMs();
+		}
+
+		Profiler& Profiler::instance() {
+			static Profiler profiler;
+			return profiler;
+		}
+
+		void Profiler::reset() {
+			for (int s = 0; s < (int)Stage::Count; ++s) hist[s].reset();
+		}
+
+		std::string Profiler::toJson() const {
+			std::ostringstream os;
+			os << "{\"enabled\":" << (kEnabled ? "true" : "false") << ",\"stages\":{";
+			bool first = true;
+			for (int s = 0; s < (int)Stage::Count; ++s) {
+				const LatencyHistogram& h = hist[s];
+				if (!first) os << ",";
+				first = false;
+				os << "\"" << stageName((Stage)s) << "\":{"
+					<< "\"count\":" << h.count()
+					<< ",\"mean_ms\":" << h.meanMs()
+					<< ",\"min_ms\":" << h.minMs()
+					<< ",\"p50_ms\":" << h.percentileMs(50.0)
+					<< ",\"p95_ms\":" << h.percentileMs(95.0)
+					<< ",\"p99_ms\":" << h.percentileMs(99.0)
+					<< ",\"max_ms\":" << h.maxMs()
+					<< "}";
+			}
+			os << "}}";
+			return os.str();
+		}
+
+		bool Profiler::writeJson(const std::string& path) const {
+			std::ofstream out(path);
+			if (!out.is_open()) return false;
+			out << toJson() << std::endl;
+			return true;
+		}
+	}
+}
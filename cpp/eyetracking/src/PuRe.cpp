@@ -38,6 +38,8 @@
 
 #include "PuRe.h"
 #include "RANSAC.h"
+#include "Resize.h"
+#include "Geometry.h"
 
 #include <climits>
 #include <iostream>
@@ -57,6 +59,7 @@ PuRe::PuRe() :
 	eyeZoomer(nullptr)
 {
 	mDesc = desc;
+	cannyEngine.setCollectPixels(true);
 
 	/*
 	 * 1) Canthi:
@@ -128,174 +131,9 @@ void PuRe::init(const Mat& frame)
 Mat PuRe::canny(const Mat& in, bool blurImage, bool useL2, int bins, float nonEdgePixelsRatio, float lowHighThresholdRatio)
 {
 	(void)useL2;
-	/* 1
-	 * Smoothing and directional derivatives
-	 * TODO: adapt sizes to image size
-	 */
-	Mat blurred;
-	if (blurImage) {
-		Size blurSize(5, 5);
-		GaussianBlur(in, blurred, blurSize, 1.5, 1.5, BORDER_REPLICATE);
-	}
-	else
-		blurred = in;
-
-	Sobel(blurred, dx, dx.type(), 1, 0, 7, 1, 0, BORDER_REPLICATE);
-	Sobel(blurred, dy, dy.type(), 0, 1, 7, 1, 0, BORDER_REPLICATE);
-
-	/*
-	 *  Magnitude
-	 */
-	double minMag = 0;
-	double maxMag = 0;
-	float* p_res;
-	float* p_x, * p_y; // result, x, y
-
-	cv::magnitude(dx, dy, magnitude);
-
-	// Normalization
-	cv::minMaxLoc(magnitude, &minMag, &maxMag);
-	magnitude = magnitude / maxMag;
-
-	/* 2
-	 *  Threshold selection based on the magnitude histogram
-	 */
-	float low_th = 0;
-	float high_th = 0;
-
-	// Histogram //ͳ���ݶ�ֱ��ͼ�����ǿ���ֱ����calcHist()
-	int* histogram = new int[bins]();
-	Mat res_idx = (bins - 1) * magnitude; //value range [0,bins-1]
-	res_idx.convertTo(res_idx, CV_16U);
-	short* p_res_idx = 0;
-	for (int i = 0; i < res_idx.rows; i++)
-	{
-		p_res_idx = res_idx.ptr<short>(i);
-		for (int j = 0; j < res_idx.cols; j++)
-			histogram[p_res_idx[j]]++;
-	}
-
-	// Ratio //�Զ�ȷ��canny����ֵ
-	int sum = 0;
-	int nonEdgePixels = nonEdgePixelsRatio * in.rows * in.cols;
-	for (int i = 0; i < bins; i++)
-	{
-		sum += histogram[i];
-		if (sum > nonEdgePixels)
-		{
-			high_th = float(i + 1) / bins;
-			break;
-		}
-	}
-	low_th = lowHighThresholdRatio * high_th;
-
-
-	/*3
-	 *  Non maximum supression
-	 */
-	const float tg22_5 = 0.4142135623730950488016887242097f;
-	const float tg67_5 = 2.4142135623730950488016887242097f;
-	uchar* _edgeType;
-	float* p_res_b, * p_res_t;
-	edgeType.setTo(0);
-	for (int i = 1; i < magnitude.rows - 1; i++)
-	{
-		_edgeType = edgeType.ptr<uchar>(i);
-
-		p_res = magnitude.ptr<float>(i);
-		p_res_t = magnitude.ptr<float>(i - 1);
-		p_res_b = magnitude.ptr<float>(i + 1);
-
-		p_x = dx.ptr<float>(i);
-		p_y = dy.ptr<float>(i);
-
-		for (int j = 1; j < magnitude.cols - 1; j++)
-		{
-			float m = p_res[j];
-			if (m < low_th)
-				continue;
-
-			float iy = p_y[j];
-			float ix = p_x[j];
-			float y = abs((double)iy);
-			float x = abs((double)ix);
-
-			uchar val = p_res[j] > high_th ? 255 : 128;
-
-			float tg22_5x = tg22_5 * x;
-			if (y < tg22_5x)
-			{
-				if (m > p_res[j - 1] && m >= p_res[j + 1])
-					_edgeType[j] = val;
-			}
-			else
-			{
-				float tg67_5x = tg67_5 * x;
-				if (y > tg67_5x)
-				{
-					if (m > p_res_b[j] && m >= p_res_t[j])
-						_edgeType[j] = val;
-				}
-				else
-				{
-					if ((iy <= 0) == (ix <= 0))
-					{
-						if (m > p_res_t[j - 1] && m >= p_res_b[j + 1])
-							_edgeType[j] = val;
-					}
-					else
-					{
-						if (m > p_res_b[j - 1] && m >= p_res_t[j + 1])
-							_edgeType[j] = val;
-					}
-				}
-			}
-		}
-	}
-
-	/*4
-	 *  Hystheresis
-	 */
-	int pic_x = edgeType.cols;
-	int pic_y = edgeType.rows;
-	int area = pic_x * pic_y;
-	int lines_idx = 0;
-	int idx = 0;
-
-	vector<int> lines;
-	edge.setTo(0);
-	for (int i = 1; i < pic_y - 1; i++) {
-		for (int j = 1; j < pic_x - 1; j++) {
-
-			if (edgeType.data[idx + j] != 255 || edge.data[idx + j] != 0)
-				continue;
-
-			edge.data[idx + j] = 255;
-			lines_idx = 1;
-			lines.clear();
-			lines.push_back(idx + j);
-			int akt_idx = 0;
-
-			while (akt_idx < lines_idx) {
-				int akt_pos = lines[akt_idx];
-				akt_idx++;
-
-				if (akt_pos - pic_x - 1 < 0 || akt_pos + pic_x + 1 >= area)
-					continue;
-
-				for (int k1 = -1; k1 < 2; k1++)
-					for (int k2 = -1; k2 < 2; k2++) {
-						if (edge.data[(akt_pos + (k1 * pic_x)) + k2] != 0 || edgeType.data[(akt_pos + (k1 * pic_x)) + k2] == 0)
-							continue;
-						edge.data[(akt_pos + (k1 * pic_x)) + k2] = 255;
-						lines.push_back((akt_pos + (k1 * pic_x)) + k2);
-						lines_idx++;
-					}
-			}
-		}
-		idx += pic_x;
-	}
-	return edge;
+	// Always L2, as in the reference implementation. The returned edges are the
+	// engine's buffer; they stay valid (and writable) until the next call.
+	return cannyEngine.detect(in, blurImage, true, bins, nonEdgePixelsRatio, lowHighThresholdRatio);
 }
 
 /**
@@ -304,235 +142,11 @@ orthogonal connections following the procedure described by Fuhl et al. (2016c).
 */
 void PuRe::filterEdges(cv::Mat& edges)
 {
-	// TODO: there is room for improvement here; however, it is prone to small
-	// mistakes; will be done when we have time
-	int start_x = 5;
-	int start_y = 5;
-	int end_x = edges.cols - 5;
-	int end_y = edges.rows - 5;
-
-	for (int j = start_y; j < end_y; j++)
-		for (int i = start_x; i < end_x; i++) {
-			uchar box[9];
-
-			box[4] = (uchar)edges.data[(edges.cols * (j)) + (i)];
-
-			if (box[4]) {
-				box[1] = (uchar)edges.data[(edges.cols * (j - 1)) + (i)];
-				box[3] = (uchar)edges.data[(edges.cols * (j)) + (i - 1)];
-				box[5] = (uchar)edges.data[(edges.cols * (j)) + (i + 1)];
-				box[7] = (uchar)edges.data[(edges.cols * (j + 1)) + (i)];
-
-
-				if ((box[5] && box[7])) edges.data[(edges.cols * (j)) + (i)] = 0;
-				if ((box[5] && box[1])) edges.data[(edges.cols * (j)) + (i)] = 0;
-				if ((box[3] && box[7])) edges.data[(edges.cols * (j)) + (i)] = 0;
-				if ((box[3] && box[1])) edges.data[(edges.cols * (j)) + (i)] = 0;
-
-			}
-		}
-
-	//too many neigbours
-	for (int j = start_y; j < end_y; j++)
-		for (int i = start_x; i < end_x; i++) {
-			uchar neig = 0;
-
-			for (int k1 = -1; k1 < 2; k1++)
-				for (int k2 = -1; k2 < 2; k2++) {
-
-					if (edges.data[(edges.cols * (j + k1)) + (i + k2)] > 0)
-						neig++;
-				}
-
-			if (neig > 3)
-				edges.data[(edges.cols * (j)) + (i)] = 0;
-
-		}
-
-	for (int j = start_y; j < end_y; j++)
-		for (int i = start_x; i < end_x; i++) {
-			uchar box[17];
-
-			box[4] = (uchar)edges.data[(edges.cols * (j)) + (i)];
-
-			if (box[4]) {
-				box[0] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 1)];
-				box[1] = (uchar)edges.data[(edges.cols * (j - 1)) + (i)];
-				box[2] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 1)];
-
-				box[3] = (uchar)edges.data[(edges.cols * (j)) + (i - 1)];
-				box[5] = (uchar)edges.data[(edges.cols * (j)) + (i + 1)];
-
-				box[6] = (uchar)edges.data[(edges.cols * (j + 1)) + (i - 1)];
-				box[7] = (uchar)edges.data[(edges.cols * (j + 1)) + (i)];
-				box[8] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 1)];
-
-				//external
-				box[9] = (uchar)edges.data[(edges.cols * (j)) + (i + 2)];
-				box[10] = (uchar)edges.data[(edges.cols * (j + 2)) + (i)];
-
-
-				box[11] = (uchar)edges.data[(edges.cols * (j)) + (i + 3)];
-				box[12] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 2)];
-				box[13] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 2)];
-
-
-				box[14] = (uchar)edges.data[(edges.cols * (j + 3)) + (i)];
-				box[15] = (uchar)edges.data[(edges.cols * (j + 2)) + (i - 1)];
-				box[16] = (uchar)edges.data[(edges.cols * (j + 2)) + (i + 1)];
-
-
-
-				if ((box[10] && !box[7]) && (box[8] || box[6])) {
-					edges.data[(edges.cols * (j + 1)) + (i - 1)] = 0;
-					edges.data[(edges.cols * (j + 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j + 1)) + (i)] = 255;
-				}
-
-
-				if ((box[14] && !box[7] && !box[10]) && ((box[8] || box[6]) && (box[16] || box[15]))) {
-					edges.data[(edges.cols * (j + 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j + 1)) + (i - 1)] = 0;
-					edges.data[(edges.cols * (j + 2)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j + 2)) + (i - 1)] = 0;
-					edges.data[(edges.cols * (j + 1)) + (i)] = 255;
-					edges.data[(edges.cols * (j + 2)) + (i)] = 255;
-				}
-
-
-
-				if ((box[9] && !box[5]) && (box[8] || box[2])) {
-					edges.data[(edges.cols * (j + 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j - 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j)) + (i + 1)] = 255;
-				}
-
-
-				if ((box[11] && !box[5] && !box[9]) && ((box[8] || box[2]) && (box[13] || box[12]))) {
-					edges.data[(edges.cols * (j + 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j - 1)) + (i + 1)] = 0;
-					edges.data[(edges.cols * (j + 1)) + (i + 2)] = 0;
-					edges.data[(edges.cols * (j - 1)) + (i + 2)] = 0;
-					edges.data[(edges.cols * (j)) + (i + 1)] = 255;
-					edges.data[(edges.cols * (j)) + (i + 2)] = 255;
-				}
-
-			}
-		}
-
-	for (int j = start_y; j < end_y; j++)
-		for (int i = start_x; i < end_x; i++) {
-
-			uchar box[33];
-
-			box[4] = (uchar)edges.data[(edges.cols * (j)) + (i)];
-
-			if (box[4]) {
-				box[0] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 1)];
-				box[1] = (uchar)edges.data[(edges.cols * (j - 1)) + (i)];
-				box[2] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 1)];
-
-				box[3] = (uchar)edges.data[(edges.cols * (j)) + (i - 1)];
-				box[5] = (uchar)edges.data[(edges.cols * (j)) + (i + 1)];
-
-				box[6] = (uchar)edges.data[(edges.cols * (j + 1)) + (i - 1)];
-				box[7] = (uchar)edges.data[(edges.cols * (j + 1)) + (i)];
-				box[8] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 1)];
-
-				box[9] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 2)];
-				box[10] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 2)];
-				box[11] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 2)];
-				box[12] = (uchar)edges.data[(edges.cols * (j + 1)) + (i - 2)];
-
-				box[13] = (uchar)edges.data[(edges.cols * (j - 2)) + (i - 1)];
-				box[14] = (uchar)edges.data[(edges.cols * (j - 2)) + (i + 1)];
-				box[15] = (uchar)edges.data[(edges.cols * (j + 2)) + (i - 1)];
-				box[16] = (uchar)edges.data[(edges.cols * (j + 2)) + (i + 1)];
-
-				box[17] = (uchar)edges.data[(edges.cols * (j - 3)) + (i - 1)];
-				box[18] = (uchar)edges.data[(edges.cols * (j - 3)) + (i + 1)];
-				box[19] = (uchar)edges.data[(edges.cols * (j + 3)) + (i - 1)];
-				box[20] = (uchar)edges.data[(edges.cols * (j + 3)) + (i + 1)];
-
-				box[21] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 3)];
-				box[22] = (uchar)edges.data[(edges.cols * (j + 1)) + (i - 3)];
-				box[23] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 3)];
-				box[24] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 3)];
-
-				box[25] = (uchar)edges.data[(edges.cols * (j - 2)) + (i - 2)];
-				box[26] = (uchar)edges.data[(edges.cols * (j + 2)) + (i + 2)];
-				box[27] = (uchar)edges.data[(edges.cols * (j - 2)) + (i + 2)];
-				box[28] = (uchar)edges.data[(edges.cols * (j + 2)) + (i - 2)];
-
-				box[29] = (uchar)edges.data[(edges.cols * (j - 3)) + (i - 3)];
-				box[30] = (uchar)edges.data[(edges.cols * (j + 3)) + (i + 3)];
-				box[31] = (uchar)edges.data[(edges.cols * (j - 3)) + (i + 3)];
-				box[32] = (uchar)edges.data[(edges.cols * (j + 3)) + (i - 3)];
-
-				if (box[7] && box[2] && box[9])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[7] && box[0] && box[10])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[1] && box[8] && box[11])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[1] && box[6] && box[12])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-
-				if (box[0] && box[13] && box[17] && box[8] && box[11] && box[21])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[2] && box[14] && box[18] && box[6] && box[12] && box[22])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[6] && box[15] && box[19] && box[2] && box[9] && box[23])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[8] && box[16] && box[20] && box[0] && box[10] && box[24])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-
-				if (box[0] && box[25] && box[2] && box[27])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[0] && box[25] && box[6] && box[28])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[8] && box[26] && box[2] && box[27])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box[8] && box[26] && box[6] && box[28])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-
-				uchar box2[18];
-				box2[1] = (uchar)edges.data[(edges.cols * (j)) + (i - 1)];
-
-				box2[2] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 2)];
-				box2[3] = (uchar)edges.data[(edges.cols * (j - 2)) + (i - 3)];
-
-				box2[4] = (uchar)edges.data[(edges.cols * (j - 1)) + (i + 1)];
-				box2[5] = (uchar)edges.data[(edges.cols * (j - 2)) + (i + 2)];
-
-				box2[6] = (uchar)edges.data[(edges.cols * (j + 1)) + (i - 2)];
-				box2[7] = (uchar)edges.data[(edges.cols * (j + 2)) + (i - 3)];
-
-				box2[8] = (uchar)edges.data[(edges.cols * (j + 1)) + (i + 1)];
-				box2[9] = (uchar)edges.data[(edges.cols * (j + 2)) + (i + 2)];
-
-				box2[10] = (uchar)edges.data[(edges.cols * (j + 1)) + (i)];
-
-				box2[15] = (uchar)edges.data[(edges.cols * (j - 1)) + (i - 1)];
-				box2[16] = (uchar)edges.data[(edges.cols * (j - 2)) + (i - 2)];
-
-				box2[11] = (uchar)edges.data[(edges.cols * (j + 2)) + (i + 1)];
-				box2[12] = (uchar)edges.data[(edges.cols * (j + 3)) + (i + 2)];
-
-				box2[13] = (uchar)edges.data[(edges.cols * (j + 2)) + (i - 1)];
-				box2[14] = (uchar)edges.data[(edges.cols * (j + 3)) + (i - 2)];
-
-				if (box2[1] && box2[2] && box2[3] && box2[4] && box2[5])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box2[1] && box2[6] && box2[7] && box2[8] && box2[9])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box2[10] && box2[11] && box2[12] && box2[4] && box2[5])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-				if (box2[10] && box2[13] && box2[14] && box2[15] && box2[16])
-					edges.data[(edges.cols * (j)) + (i)] = 0;
-			}
-
-		}
+	// Bit-packed, table-driven version of the four rule passes; same in-place
+	// semantics (see vision::edge::EdgeFilter). Driven by the pixels hysteresis
+	// accepted, so sparse edge maps cost what they hold, not the frame area
+	edgePixels = cannyEngine.pixels();
+	edgeFilter.apply(edges, edgePixels);
 }
 
 void PuRe::findPupilEdgeCandidates(const Mat& intensityImage, Mat& edge, vector<PupilCandidate>& candidates)
@@ -541,12 +155,23 @@ void PuRe::findPupilEdgeCandidates(const Mat& intensityImage, Mat& edge, vector<
 	 * Small note here: using anchor points tends to result in better ellipse fitting later!
 	 * It's also faster than doing connected components and collecting the labels
 	 */
-	vector<Vec4i> hierarchy;
 	vector<vector<Point> > curves;
-	findContours(edge, curves, hierarchy, cv::RETR_LIST,
-		cv::CHAIN_APPROX_TC89_KCOS);
+	if (linkEdges) {
+		// The filtered edges are one pixel wide, so walk them into segments
+		// directly: each pixel lands in one segment and there is nothing to
+		// deduplicate. edgePixels still lists them, minus any masking since.
+		edgeLinker.link(edge, edgePixels, vision::edge::LinkPoints::Anchors);
+		curves.reserve(edgeLinker.count());
+		for (size_t i = 0; i < edgeLinker.count(); i++)
+			curves.push_back(edgeLinker.segment(i));
+	}
+	else {
+		vector<Vec4i> hierarchy;
+		findContours(edge, curves, hierarchy, cv::RETR_LIST,
+			cv::CHAIN_APPROX_TC89_KCOS);
 
-	removeDuplicates(curves, edge.cols);//ɾ���ظ���curves������ʵ���ϲ�û���ظ��ģ��о�����
+		removeDuplicates(curves, edge.cols);//ɾ���ظ���curves������ʵ���ϲ�û���ظ��ģ��о�����
+	}
 
 	// Create valid candidates
 	for (size_t i = curves.size(); i-- > 0;) {
@@ -615,6 +240,36 @@ void PuRe::searchInnerCandidates(vector<PupilCandidate>& candidates, PupilCandid
 	//imshow("dbg", dbg);
 }
 
+// Hands the working image (and the selected candidate, if any) to the debug sink.
+// Only a copy is taken here; conversion and drawing happen on the sink's thread.
+void PuRe::postSelectedDebug(const PupilCandidate* selected)
+{
+	if (!debugSink.enabled())
+		return;
+
+	Mat snapshot = input.clone();
+	if (selected == nullptr) {
+		debugSink.post("selected", [snapshot]() {
+			Mat selectedImage;
+			cv::cvtColor(snapshot, selectedImage, cv::COLOR_GRAY2BGR);
+			cv::putText(selectedImage, "No candidate", cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255));
+			return selectedImage;
+			});
+		return;
+	}
+
+	std::vector<Point> points = selected->points;
+	debugSink.post("selected", [snapshot, points]() {
+		Mat selectedImage;
+		cv::cvtColor(snapshot, selectedImage, cv::COLOR_GRAY2BGR);
+		if (!points.empty()) {
+			PupilCandidate candidate(points);
+			candidate.draw(selectedImage, Scalar(255, 0, 0));
+		}
+		return selectedImage;
+		});
+}
+
 // My Own Function
 void PuRe::detect(Pupil& pupil, const cv::Mat& fullFrame)
 {
@@ -649,11 +304,7 @@ void PuRe::detect(Pupil& pupil, const cv::Mat& fullFrame)
 	findPupilEdgeCandidates(input, detectedEdges, candidates);
 	if (candidates.size() <= 0)
 	{
-		Mat selectedImage;
-		cv::cvtColor(input, selectedImage, cv::COLOR_GRAY2BGR);
-		cv::putText(selectedImage, "No candidate", cv::Point(10, 20),
-			cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255));
-		imshow("selected", selectedImage);
+		postSelectedDebug(nullptr);
 		return;
 	}
 
@@ -672,10 +323,7 @@ void PuRe::detect(Pupil& pupil, const cv::Mat& fullFrame)
 	sort(candidates.begin(), candidates.end());
 	PupilCandidate selected = candidates.back();
 
-	Mat selectedImage;
-	cv::cvtColor(input, selectedImage, cv::COLOR_GRAY2BGR);
-	selected.draw(selectedImage, Scalar(255, 0, 0));
-	imshow("selected", selectedImage);
+	postSelectedDebug(&selected);
 
 	// Post processing
 	searchInnerCandidates(candidates, selected);
@@ -737,11 +385,8 @@ void PuRe::detect(Pupil& pupil)
 	findPupilEdgeCandidates(input, detectedEdges, candidates);
 	if (candidates.size() <= 0)
 	{
-		// Always refresh the debug window so it updates live even when no selection exists
-		Mat selectedImage;
-		cv::cvtColor(input, selectedImage, cv::COLOR_GRAY2BGR);
-		cv::putText(selectedImage, "No candidate", cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255));
-		imshow("selected", selectedImage);
+		// Always refresh the debug view so it updates live even when no selection exists
+		postSelectedDebug(nullptr);
 		return;
 	}
 
@@ -792,10 +437,7 @@ void PuRe::detect(Pupil& pupil)
 	sort(candidates.begin(), candidates.end());
 	PupilCandidate selected = candidates.back();
 
-	Mat selectedImage;
-	cv::cvtColor(input, selectedImage, cv::COLOR_GRAY2BGR);
-	selected.draw(selectedImage, Scalar(255, 0, 0));
-	imshow("selected", selectedImage);
+	postSelectedDebug(&selected);
 
 	//for ( auto c = candidates.begin(); c != candidates.end(); c++)
 	//    c->draw(dbg);
@@ -862,6 +504,18 @@ void PuRe::initHaar(const std::string& faceCascadePath, const std::string& eyeCa
 	}
 }
 
+// Resize + min-max normalize into the persistent input buffer. 8-bit gray frames
+// take the fused kernel; anything else keeps the two-pass OpenCV path.
+void PuRe::downscaleInput(const Mat& frame)
+{
+	if (frame.type() == CV_8UC1) {
+		vision::resize::resizeNormalize(frame, input, scalingRatio, scalingRatio);
+		return;
+	}
+	resize(frame, downscaled, Size(), scalingRatio, scalingRatio, cv::INTER_LINEAR);
+	normalize(downscaled, input, 0, 255, NORM_MINMAX, CV_8U);
+}
+
 void PuRe::run(const Mat& frame, Pupil& pupil)
 {
 	pupil.clear();
@@ -869,10 +523,7 @@ void PuRe::run(const Mat& frame, Pupil& pupil)
 	init(frame);
 
 	// 3.1 Preprocessing: Downscaling
-	Mat downscaled = frame;
-	resize(frame, downscaled, Size(), scalingRatio, scalingRatio, cv::INTER_LINEAR);
-	normalize(downscaled, input, 0, 255, NORM_MINMAX, CV_8U);
-
+	downscaleInput(frame);
 
 	workingSize.width = floor(scalingRatio * frame.cols);
 	workingSize.height = floor(scalingRatio * frame.rows);
@@ -880,12 +531,6 @@ void PuRe::run(const Mat& frame, Pupil& pupil)
 	// Estimate parameters based on the working size
 	estimateParameters(workingSize.height, workingSize.width);
 
-	// Preallocate stuff for edge detection
-	dx = Mat::zeros(workingSize, CV_32F);
-	dy = Mat::zeros(workingSize, CV_32F);
-	magnitude = Mat::zeros(workingSize, CV_32F);
-	edgeType = Mat::zeros(workingSize, CV_8U);
-	edge = Mat::zeros(workingSize, CV_8U);
 
 	//cvtColor(input, dbg, CV_GRAY2BGR);
 	//circle(dbg, Point(0.5*dbg.cols,0.5*dbg.rows), 0.5*minPupilDiameterPx, Scalar(0,0,0), 2);
@@ -919,21 +564,13 @@ void PuRe::run(const cv::Mat& frame, const cv::Rect& roi, Pupil& pupil, const fl
 		maxPupilDiameterPx = scalingRatio * userMaxPupilDiameterPx;
 
 	// Downscaling
-	Mat downscaled;
-	resize(frame(roi), downscaled, Size(), scalingRatio, scalingRatio, cv::INTER_LINEAR);
-	normalize(downscaled, input, 0, 255, NORM_MINMAX, CV_8U);
+	downscaleInput(frame(roi));
 
 	//cvtColor(input, dbg, CV_GRAY2BGR);
 
 	workingSize.width = input.cols;
 	workingSize.height = input.rows;
 
-	// Preallocate stuff for edge detection
-	dx = Mat::zeros(workingSize, CV_32F);
-	dy = Mat::zeros(workingSize, CV_32F);
-	magnitude = Mat::zeros(workingSize, CV_32F);
-	edgeType = Mat::zeros(workingSize, CV_8U);
-	edge = Mat::zeros(workingSize, CV_8U);
 
 	//cvtColor(input, dbg, CV_GRAY2BGR);
 	//circle(dbg, Point(0.5*dbg.cols,0.5*dbg.rows), 0.5*minPupilDiameterPx, Scalar(0,0,0), 2);
@@ -983,21 +620,12 @@ void PuRe::run(const Mat& frame, Pupil& pupil, bool useHaarCascade)
 	}
 
 	// 3.1 Preprocessing: Downscaling
-	Mat downscaled = frame;
-	resize(frame, downscaled, Size(), scalingRatio, scalingRatio, cv::INTER_LINEAR);
-	normalize(downscaled, input, 0, 255, NORM_MINMAX, CV_8U);
-
+	downscaleInput(frame);
 	workingSize.width = floor(scalingRatio * frame.cols);
 	workingSize.height = floor(scalingRatio * frame.rows);
 
 	estimateParameters(workingSize.height, workingSize.width);
 
-	dx = Mat::zeros(workingSize, CV_32F);
-	dy = Mat::zeros(workingSize, CV_32F);
-	magnitude = Mat::zeros(workingSize, CV_32F);
-	edgeType = Mat::zeros(workingSize, CV_8U);
-	edge = Mat::zeros(workingSize, CV_8U);
-
 	detect(pupil, frame);
 	pupil.resize(1.0 / scalingRatio, 1.0 / scalingRatio);
 }
@@ -1128,14 +756,11 @@ inline bool PupilCandidate::isValid(const cv::Mat& intensityImage, const int& mi
 		return false;
 
 	//2 Segment����ֱ��Լ��
-	float maxGap = 0;
-	for (auto p1 = points.begin(); p1 != points.end(); p1++) {
-		for (auto p2 = p1 + 1; p2 != points.end(); p2++) {
-			float gap = norm(*p2 - *p1);
-			if (gap > maxGap)
-				maxGap = gap;
-		}
-	}
+	// A bounding box side already at the limit rejects long contours without
+	// measuring them; otherwise the exact diameter via hull + rotating calipers
+	if (vision::geometry::boundingBoxExceeds(points, maxPupilDiameterPx))
+		return false;
+	float maxGap = vision::geometry::diameter(points);
 	if (maxGap >= maxPupilDiameterPx || maxGap <= minPupilDiameterPx)
 		return false;
 	//if (maxGap <= minPupilDiameterPx)
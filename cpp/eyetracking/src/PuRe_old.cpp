@@ -4,6 +4,7 @@
 #include "EdgeDetection.h"
 #include "EdgeProcessing.h"
 #include "HistEq.h"
+#include "Geometry.h"
 
 #include <bitset>
 #include <algorithm>
@@ -211,7 +212,7 @@ namespace pure_old {
     }
 
     void Detector::detect_edges() {
-        edge_img = vision::canny::canny(orig_img, true);
+        edge_img = canny_engine.detect(orig_img, true);
         vision::edge::filterEdges(edge_img);
     }
 
@@ -278,25 +279,12 @@ namespace pure_old {
 
     bool Detector::segment_diameter_valid(const Segment& segment) const
     {
-        double approx_diameter = 0;
-        const auto end = segment.end();
-        for (auto p1 = segment.begin(); p1 != end; ++p1)
+        // The diameter is at least the bounding box's longer side
+        if (vision::geometry::boundingBoxExceeds(segment, max_pupil_diameter))
         {
-            for (auto p2 = p1 + 1; p2 != end; ++p2)
-            {
-                approx_diameter = std::max(approx_diameter, cv::norm(*p1 - *p2));
-                // we can early exit, because we will only get bigger
-                if (approx_diameter > max_pupil_diameter)
-                {
-                    break;
-                }
-            }
-            // we can early exit, because we will only get bigger
-            if (approx_diameter > max_pupil_diameter)
-            {
-                break;
-            }
+            return false;
         }
+        const double approx_diameter = std::sqrt((double)vision::geometry::squaredDiameter(segment));
         return min_pupil_diameter < approx_diameter && approx_diameter < max_pupil_diameter;
     }
 
@@ -1,10 +1,13 @@
 #include "PupilDetector.h"
+#include "Profiler.h"
 #include <iostream>
 
 namespace vision {
 	namespace detection {
 		PupilDetector::PupilDetector(const std::string& faceCascadePath, const std::string& eyeCascadePath)
 			: zoomer(faceCascadePath, eyeCascadePath, 200, 200)
+			, clahe(2.0, cv::Size(6, 6))
+			, useTemporalClahe(false)
 			, haarLocked(false)
 			, roiMargin(10)
 			, hasPrevPupil(false)
@@ -23,6 +26,7 @@ namespace vision {
 			haarLocked = false;
 			hasPrevPupil = false;
 			hasSmooth = false;
+			clahe.reset();
 		}
 		
 		Pupil PupilDetector::processFrame(const cv::Mat& frame, bool useHaar) {
@@ -30,15 +34,37 @@ namespace vision {
 				Pupil empty;
 				return empty;
 			}
+			VISION_PROFILE_SCOPE(Total);
 			
 			// Step 1: Resize frame to default height
-			cv::Mat frameSmall = vision::scale::resizeToHeight(frame, 512);
-			cv::flip(frameSmall, frameSmall, 1); // Mirror
+			cv::Mat frameSmall;
+			{
+				VISION_PROFILE_SCOPE(Resize);
+				frameSmall = vision::scale::resizeToHeight(frame, 512);
+			}
+			// Everything below runs on gray. Luma frames are used as they are; BGR
+			// frames are converted once, here.
 			cv::Mat gray;
-			cv::cvtColor(frameSmall, gray, cv::COLOR_BGR2GRAY);
+			if (frameSmall.channels() == 1) {
+				gray = frameSmall;
+			}
+			else {
+				VISION_PROFILE_SCOPE(CvtColor);
+				cv::cvtColor(frameSmall, gray, cv::COLOR_BGR2GRAY);
+			}
+			{
+				VISION_PROFILE_SCOPE(Flip);
+				// Out of place: gray may share data with the caller's frame
+				cv::Mat mirrored;
+				cv::flip(gray, mirrored, 1); // Mirror
+				gray = mirrored;
+			}
+			// Kept (unmirrored) for getWorkingFrame
+			viewSource = frameSmall;
 			
 			// Step 2: Haar detection and ROI locking
 			if (useHaar && !haarLocked) {
+				VISION_PROFILE_SCOPE(Haar);
 				EyeZoomResult zr = zoomer.processFrame(gray);
 				if (!zr.eyeRects.empty()) {
 					cv::Rect acc;
@@ -46,8 +72,8 @@ namespace vision {
 					if (acc.area() > 0) {
 						acc.x = std::max(0, acc.x - roiMargin);
 						acc.y = std::max(0, acc.y - roiMargin);
-						acc.width = std::min(frameSmall.cols - acc.x, acc.width + 2 * roiMargin);
-						acc.height = std::min(frameSmall.rows - acc.y, acc.height + 2 * roiMargin);
+						acc.width = std::min(gray.cols - acc.x, acc.width + 2 * roiMargin);
+						acc.height = std::min(gray.rows - acc.y, acc.height + 2 * roiMargin);
 						lockedRoi = acc;
 						haarLocked = true;
 					}
@@ -57,33 +83,49 @@ namespace vision {
 			// Step 3: Extract working region
 			cv::Mat working;
 			if (haarLocked) {
-				working = frameSmall(lockedRoi).clone();
+				working = gray(lockedRoi);
 				currentRoi = lockedRoi;
 			} else {
-				working = frameSmall;
-				currentRoi = cv::Rect(0, 0, frameSmall.cols, frameSmall.rows);
+				working = gray;
+				currentRoi = cv::Rect(0, 0, gray.cols, gray.rows);
 			}
 			
 			// Step 4: Resize ROI if it's too small (KEY REQUIREMENT)
 			// This ensures detector/purest run on properly sized images
 			double originalHeight = working.rows;
-			cv::Mat workingResized = vision::scale::resizeToHeight(working, vision::scale::kDefaultHeight);
-			roiScaleFactor = (originalHeight > 0) ? (workingResized.rows / originalHeight) : 1.0;
-			cv::cvtColor(workingResized, workingGray, cv::COLOR_BGR2GRAY);
+			{
+				VISION_PROFILE_SCOPE(RoiResize);
+				vision::scale::resizeToHeight(working, workingGray, vision::scale::kDefaultHeight);
+			}
+			roiScaleFactor = (originalHeight > 0) ? (workingGray.rows / originalHeight) : 1.0;
 
 			// Optional: Morphological closing to reduce noise
-			cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
-			cv::morphologyEx(workingGray, workingGray, cv::MORPH_CLOSE, kernel);
-			
-			// Store for visualization
-			workingFrame = workingResized.clone();
+			// (written to a fresh image, workingGray may still be a view of gray)
+			{
+				VISION_PROFILE_SCOPE(Morphology);
+				cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
+				cv::Mat closed;
+				cv::morphologyEx(workingGray, closed, cv::MORPH_CLOSE, kernel);
+				workingGray = closed;
+			}
 			
 			// Step 5: Preprocessing
-			cv::Mat enhanced = vision::pre::enhanceForPupil(workingGray, 2.0, cv::Size(6, 6), 5, 40.0, 5.0, 1.0, 0.8);
-			cv::Mat clahe = enhanced;
+			cv::Mat enhanced;
+			{
+				VISION_PROFILE_SCOPE(Enhance);
+				if (useTemporalClahe)
+					enhanced = vision::pre::enhanceForPupil(workingGray, clahe, 5, 40.0, 5.0, 1.0, 0.8);
+				else
+					enhanced = vision::pre::enhanceForPupil(workingGray, 2.0, cv::Size(6, 6), 5, 40.0, 5.0, 1.0, 0.8);
+			}
+			cv::Mat enhancedFrame = enhanced;
 			
 			// Step 6: Detection/tracking
-			Pupil pupil = detectPupil(clahe);
+			Pupil pupil;
+			{
+				VISION_PROFILE_SCOPE(Detect);
+				pupil = detectPupil(enhancedFrame);
+			}
 			
 			// Step 7: Update previous pupil for tracking
 			if (pupil.size.width > 0) {
@@ -95,8 +137,12 @@ namespace vision {
 			bool valid = false;
 			double contrastScore = 0.0;
 			if (pupil.size.width > 0) {
-				valid = validatePupil(pupil, workingGray);
+				{
+					VISION_PROFILE_SCOPE(Validate);
+					valid = validatePupil(pupil, workingGray);
+				}
 				if (valid) {
+					VISION_PROFILE_SCOPE(Smooth);
 					// Compute contrast score for smoothing
 					float rIn = 0.25f * (float)std::min(pupil.size.width, pupil.size.height);
 					float rOut = 0.5f * (float)std::max(pupil.size.width, pupil.size.height);
@@ -167,24 +213,38 @@ namespace vision {
 			return transformed;
 		}
 		
-		Pupil PupilDetector::detectPupil(const cv::Mat& clahe) {
+		cv::Mat PupilDetector::getWorkingFrame() const {
+			if (viewSource.empty()) return cv::Mat();
+			// currentRoi is in mirrored coordinates; take the matching unmirrored
+			// region so only the ROI gets flipped, resized and colour converted
+			cv::Rect region(viewSource.cols - currentRoi.x - currentRoi.width, currentRoi.y,
+				currentRoi.width, currentRoi.height);
+			cv::Mat mirrored;
+			cv::flip(viewSource(region), mirrored, 1);
+			cv::Mat view = vision::scale::resizeToHeight(mirrored, vision::scale::kDefaultHeight);
+			if (view.channels() == 1)
+				cv::cvtColor(view, view, cv::COLOR_GRAY2BGR);
+			return view;
+		}
+		
+		Pupil PupilDetector::detectPupil(const cv::Mat& frame) {
 			Pupil pupil;
 			
 			// Detection/tracking stack: PuRe for init, PuReST for tracking
 			if (hasPrevPupil && haarLocked) {
-				cv::Rect full(0, 0, clahe.cols, clahe.rows);
+				cv::Rect full(0, 0, frame.cols, frame.rows);
 				cv::Rect roi = full;
 				Pupil tracked;
-				purest.run(clahe, roi, prevPupil, tracked);
+				purest.run(frame, roi, prevPupil, tracked);
 				if (tracked.size.width > 0) {
 					//std::cout << "Tracked pupil at: " << tracked.center << " size: " << tracked.size << std::endl;
 					pupil = tracked;
 				} else {
 					// Fallback to full detection
-					detector.run(clahe, pupil);
+					detector.run(frame, pupil);
 				}
 			} else {
-				detector.run(clahe, pupil);
+				detector.run(frame, pupil);
 			}
 			
 			return pupil;
@@ -1,6 +1,11 @@
 #include "Resize.h"
 #include "Utils.h"
+#include "Simd.h"
 #include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
 
 namespace vision {
     namespace resize {
@@ -14,6 +19,454 @@ namespace vision {
             return 0;
         }
 
+        // ------------------------------------------------------------------
+        // Coefficient tables
+        // Built once per call for each axis: for every destination index the
+        // source indices it reads and their Q11 weights (sum 2048). The
+        // horizontal pass produces Q11 ints per row, the vertical pass combines
+        // rows and rounds once.
+        // ------------------------------------------------------------------
+        static const int kCoefBits = 11;
+        static const int kCoefScale = 1 << kCoefBits;
+
+        struct AxisTable {
+            int taps = 0;
+            std::vector<int> index;   // dstLen * taps, source index (x tables are pre-multiplied by cn)
+            std::vector<int> weight;  // dstLen * taps, Q11
+        };
+
+        static void buildNearest(int dstLen, int srcLen, double scale, int cn, AxisTable& t) {
+            t.taps = 1;
+            t.index.resize(dstLen);
+            t.weight.assign(dstLen, kCoefScale);
+            for (int i = 0; i < dstLen; ++i)
+                t.index[i] = clamp(int(std::round((i + 0.5) / scale - 0.5)), 0, srcLen - 1) * cn;
+        }
+
+        static void buildLinear(int dstLen, int srcLen, double scale, int cn, AxisTable& t) {
+            t.taps = 2;
+            t.index.resize(dstLen * 2);
+            t.weight.resize(dstLen * 2);
+            for (int i = 0; i < dstLen; ++i) {
+                double s = (i + 0.5) / scale - 0.5;
+                int i0 = static_cast<int>(std::floor(s));
+                double f = s - i0;
+                if (i0 < 0) { i0 = 0; f = 0; }
+                int i1 = std::min(i0 + 1, srcLen - 1);
+                i0 = std::min(i0, srcLen - 1);
+                int w0 = cv::saturate_cast<short>((1.0 - f) * kCoefScale);
+                t.index[2 * i] = i0 * cn;
+                t.index[2 * i + 1] = i1 * cn;
+                t.weight[2 * i] = w0;
+                t.weight[2 * i + 1] = kCoefScale - w0;
+            }
+        }
+
+        static void buildCubic(int dstLen, int srcLen, double scale, int cn, AxisTable& t) {
+            t.taps = 4;
+            t.index.resize(dstLen * 4);
+            t.weight.resize(dstLen * 4);
+            for (int i = 0; i < dstLen; ++i) {
+                double s = (i + 0.5) / scale - 0.5;
+                int i0 = static_cast<int>(std::floor(s));
+                double f = s - i0;
+                if (i0 < 0) { i0 = 0; f = 0; }
+                int sum = 0;
+                for (int m = -1; m <= 2; ++m) {
+                    int w = static_cast<int>(std::lround(cubicWeight(m - f) * kCoefScale));
+                    t.index[4 * i + m + 1] = clamp(i0 + m, 0, srcLen - 1) * cn;
+                    t.weight[4 * i + m + 1] = w;
+                    sum += w;
+                }
+                // rounding error goes to the nearer of the two centre taps
+                t.weight[4 * i + (f < 0.5 ? 1 : 2)] += kCoefScale - sum;
+            }
+        }
+
+        // Area tables. Downscaling averages every source pixel the destination
+        // cell covers, with fractional weights for the partially covered ones at
+        // the edges. Upscaling interpolates linearly, but only across source
+        // pixel boundaries (same as OpenCV's INTER_AREA).
+        static void buildArea(int dstLen, int srcLen, double scale, int cn, AxisTable& t) {
+            const double inv = 1.0 / scale;
+            if (inv <= 1.0) {
+                t.taps = 2;
+                t.index.resize(dstLen * 2);
+                t.weight.resize(dstLen * 2);
+                for (int i = 0; i < dstLen; ++i) {
+                    int s0 = static_cast<int>(std::floor(i * inv));
+                    double f = (i + 1) - (s0 + 1) * scale;
+                    f = f <= 0 ? 0.0 : f - std::floor(f);
+                    if (s0 < 0) { s0 = 0; f = 0; }
+                    if (s0 >= srcLen - 1) { s0 = srcLen - 1; f = 0; }
+                    int w1 = static_cast<int>(std::lround(f * kCoefScale));
+                    t.index[2 * i] = s0 * cn;
+                    t.index[2 * i + 1] = std::min(s0 + 1, srcLen - 1) * cn;
+                    t.weight[2 * i] = kCoefScale - w1;
+                    t.weight[2 * i + 1] = w1;
+                }
+                return;
+            }
+
+            t.taps = static_cast<int>(std::ceil(inv)) + 1;
+            t.index.assign(dstLen * t.taps, 0);
+            t.weight.assign(dstLen * t.taps, 0);
+            std::vector<double> w(t.taps);
+            for (int i = 0; i < dstLen; ++i) {
+                double f1 = i * inv;
+                double f2 = std::min(f1 + inv, (double)srcLen);
+                double cell = f2 - f1;
+                int s1 = static_cast<int>(std::ceil(f1));
+                int s2 = static_cast<int>(std::floor(f2));
+                int first = s1, n = 0;
+                // left partial pixel
+                if (s1 - f1 > 1e-3) { first = s1 - 1; w[n++] = (s1 - f1) / cell; }
+                for (int j = s1; j < s2; ++j) w[n++] = 1.0 / cell;
+                // right partial pixel
+                if (f2 - s2 > 1e-3 && s2 < srcLen) w[n++] = (f2 - s2) / cell;
+
+                int* idx = &t.index[i * t.taps];
+                int* q = &t.weight[i * t.taps];
+                int sum = 0, big = 0;
+                for (int k = 0; k < n; ++k) {
+                    idx[k] = std::min(first + k, srcLen - 1) * cn;
+                    q[k] = static_cast<int>(std::lround(w[k] * kCoefScale));
+                    sum += q[k];
+                    if (q[k] > q[big]) big = k;
+                }
+                q[big] += kCoefScale - sum;
+                // unused taps read the last pixel with weight 0
+                for (int k = n; k < t.taps; ++k) idx[k] = idx[std::max(n - 1, 0)];
+            }
+        }
+
+        // ------------------------------------------------------------------
+        // Horizontal pass: one source row -> Q11 ints, dstW * cn values
+        // ------------------------------------------------------------------
+        // TAPS == 0 reads the tap count from the table (area tables)
+        template<int TAPS, int CN>
+        static void hresize(const uchar* src, int* dst, const AxisTable& t, int dstW, int cn) {
+            const int taps = TAPS ? TAPS : t.taps;
+            const int* idx = t.index.data();
+            const int* w = t.weight.data();
+            for (int x = 0; x < dstW; ++x, idx += taps, w += taps) {
+                if (CN == 1) {
+                    int acc = 0;
+                    for (int k = 0; k < taps; ++k) acc += src[idx[k]] * w[k];
+                    dst[x] = acc;
+                }
+                else if (CN == 3) {
+                    int a0 = 0, a1 = 0, a2 = 0;
+                    for (int k = 0; k < taps; ++k) {
+                        const uchar* p = src + idx[k];
+                        a0 += p[0] * w[k];
+                        a1 += p[1] * w[k];
+                        a2 += p[2] * w[k];
+                    }
+                    dst[3 * x] = a0;
+                    dst[3 * x + 1] = a1;
+                    dst[3 * x + 2] = a2;
+                }
+                else {
+                    for (int c = 0; c < cn; ++c) {
+                        int acc = 0;
+                        for (int k = 0; k < taps; ++k) acc += src[idx[k] + c] * w[k];
+                        dst[x * cn + c] = acc;
+                    }
+                }
+            }
+        }
+
+        template<int TAPS>
+        static void hresizeRow(const uchar* src, int* dst, const AxisTable& t, int dstW, int cn) {
+            if (cn == 1) hresize<TAPS, 1>(src, dst, t, dstW, cn);
+            else if (cn == 3) hresize<TAPS, 3>(src, dst, t, dstW, cn);
+            else hresize<TAPS, 0>(src, dst, t, dstW, cn);
+        }
+
+        // ------------------------------------------------------------------
+        // Vertical passes
+        // Linear drops 4 bits from the Q11 rows so they fit int16, then uses a
+        // high-half multiply; the scalar tail computes exactly the same thing so
+        // results do not depend on the SIMD level.
+        // ------------------------------------------------------------------
+        static void vresizeLinear(const int* s0, const int* s1, int b0, int b1, uchar* dst, int width) {
+            int x = 0;
+#if defined(VISION_SIMD_AVX2)
+            const __m256i wb0 = _mm256_set1_epi16((short)b0), wb1 = _mm256_set1_epi16((short)b1);
+            const __m256i delta256 = _mm256_set1_epi16(2);
+            for (; x <= width - 32; x += 32) {
+                __m256i r0a = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s0 + x)), 4),
+                    _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s0 + x + 8)), 4));
+                __m256i r1a = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s1 + x)), 4),
+                    _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s1 + x + 8)), 4));
+                __m256i r0b = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s0 + x + 16)), 4),
+                    _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s0 + x + 24)), 4));
+                __m256i r1b = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s1 + x + 16)), 4),
+                    _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(s1 + x + 24)), 4));
+                __m256i va = _mm256_adds_epi16(_mm256_mulhi_epi16(r0a, wb0), _mm256_mulhi_epi16(r1a, wb1));
+                __m256i vb = _mm256_adds_epi16(_mm256_mulhi_epi16(r0b, wb0), _mm256_mulhi_epi16(r1b, wb1));
+                va = _mm256_srai_epi16(_mm256_adds_epi16(va, delta256), 2);
+                vb = _mm256_srai_epi16(_mm256_adds_epi16(vb, delta256), 2);
+                // packs work per 128-bit lane, put the 4-byte groups back in order
+                __m256i p8 = _mm256_packus_epi16(va, vb);
+                p8 = _mm256_permutevar8x32_epi32(p8, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+                _mm256_storeu_si256((__m256i*)(dst + x), p8);
+            }
+#endif
+#if defined(VISION_SIMD_SSE2)
+            const __m128i wc0 = _mm_set1_epi16((short)b0), wc1 = _mm_set1_epi16((short)b1);
+            const __m128i delta128 = _mm_set1_epi16(2);
+            for (; x <= width - 8; x += 8) {
+                __m128i r0 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(s0 + x)), 4),
+                    _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(s0 + x + 4)), 4));
+                __m128i r1 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(s1 + x)), 4),
+                    _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(s1 + x + 4)), 4));
+                __m128i v = _mm_adds_epi16(_mm_mulhi_epi16(r0, wc0), _mm_mulhi_epi16(r1, wc1));
+                v = _mm_srai_epi16(_mm_adds_epi16(v, delta128), 2);
+                _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(v, v));
+            }
+#endif
+            for (; x < width; ++x) {
+                int v = (((s0[x] >> 4) * b0) >> 16) + (((s1[x] >> 4) * b1) >> 16);
+                dst[x] = cv::saturate_cast<uchar>((v + 2) >> 2);
+            }
+        }
+
+        // Generic vertical pass in 32 bits (Q22), used for cubic and area
+        static void vresizeTaps(const int* const* rows, const int* w, int taps, uchar* dst, int width) {
+            const int delta = 1 << (2 * kCoefBits - 1);
+            int x = 0;
+#if defined(VISION_SIMD_AVX2)
+            const __m256i d256 = _mm256_set1_epi32(delta);
+            for (; x <= width - 8; x += 8) {
+                __m256i acc = d256;
+                for (int k = 0; k < taps; ++k)
+                    acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(rows[k] + x)), _mm256_set1_epi32(w[k])));
+                acc = _mm256_srai_epi32(acc, 2 * kCoefBits);
+                __m128i p16 = _mm_packs_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+                _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(p16, p16));
+            }
+#endif
+            for (; x < width; ++x) {
+                int acc = delta;
+                for (int k = 0; k < taps; ++k) acc += rows[k][x] * w[k];
+                dst[x] = cv::saturate_cast<uchar>(acc >> (2 * kCoefBits));
+            }
+        }
+
+        // ------------------------------------------------------------------
+        // Drivers
+        // ------------------------------------------------------------------
+        static void resizeNearest(const cv::Mat& src, cv::Mat& dst, const AxisTable& xt, const AxisTable& yt) {
+            const int cn = src.channels();
+            const int dstW = dst.cols;
+#pragma omp parallel for schedule(static)
+            for (int y = 0; y < dst.rows; ++y) {
+                const uchar* s = src.ptr<uchar>(yt.index[y]);
+                uchar* d = dst.ptr<uchar>(y);
+                const int* xi = xt.index.data();
+                if (cn == 1) {
+                    for (int x = 0; x < dstW; ++x) d[x] = s[xi[x]];
+                }
+                else if (cn == 3) {
+                    for (int x = 0; x < dstW; ++x) {
+                        const uchar* p = s + xi[x];
+                        d[3 * x] = p[0]; d[3 * x + 1] = p[1]; d[3 * x + 2] = p[2];
+                    }
+                }
+                else {
+                    for (int x = 0; x < dstW; ++x)
+                        for (int c = 0; c < cn; ++c) d[x * cn + c] = s[xi[x] + c];
+                }
+            }
+        }
+
+        // Running min/max of an 8-bit row
+        static void rowMinMax(const uchar* row, int width, int& vmin, int& vmax) {
+            int x = 0;
+#if defined(VISION_SIMD_SSE2)
+            if (width >= 16) {
+                __m128i mn = _mm_set1_epi8((char)vmin), mx = _mm_set1_epi8((char)vmax);
+                for (; x <= width - 16; x += 16) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(row + x));
+                    mn = _mm_min_epu8(mn, v);
+                    mx = _mm_max_epu8(mx, v);
+                }
+                alignas(16) uchar bmin[16], bmax[16];
+                _mm_store_si128((__m128i*)bmin, mn);
+                _mm_store_si128((__m128i*)bmax, mx);
+                for (int i = 0; i < 16; ++i) {
+                    vmin = std::min<int>(vmin, bmin[i]);
+                    vmax = std::max<int>(vmax, bmax[i]);
+                }
+            }
+#endif
+            for (; x < width; ++x) {
+                vmin = std::min<int>(vmin, row[x]);
+                vmax = std::max<int>(vmax, row[x]);
+            }
+        }
+
+        // Separable linear/cubic/area resize. Each thread keeps the last 'taps' horizontally
+        // resized source rows, so consecutive output rows reuse them when upscaling.
+        // With minMax set, also returns the min and max of the output, taken from each
+        // row right after it is written.
+        static void resizeSeparable(const cv::Mat& src, cv::Mat& dst, const AxisTable& xt, const AxisTable& yt,
+            int* minMax = nullptr) {
+            const int cn = src.channels();
+            const int dstW = dst.cols;
+            const int width = dstW * cn;
+            const int taps = yt.taps;
+            if (minMax) {
+                minMax[0] = 255;
+                minMax[1] = 0;
+            }
+#pragma omp parallel
+            {
+                int localMin = 255, localMax = 0;
+                std::vector<int> buffer((size_t)taps * width);
+                std::vector<int> cached(taps, -1);
+                std::vector<const int*> rows(taps);
+                std::vector<char> used(taps);
+#pragma omp for schedule(static)
+                for (int y = 0; y < dst.rows; ++y) {
+                    const int* sy = &yt.index[y * taps];
+                    std::fill(used.begin(), used.end(), 0);
+                    // reuse rows that are already resized
+                    for (int k = 0; k < taps; ++k) {
+                        rows[k] = nullptr;
+                        for (int s = 0; s < taps; ++s) {
+                            if (cached[s] == sy[k]) {
+                                rows[k] = &buffer[(size_t)s * width];
+                                used[s] = 1;
+                                break;
+                            }
+                        }
+                    }
+                    // resize the missing ones into slots this row does not need
+                    for (int k = 0; k < taps; ++k) {
+                        if (rows[k]) continue;
+                        int s = 0;
+                        while (used[s]) ++s;
+                        used[s] = 1;
+                        cached[s] = sy[k];
+                        int* out = &buffer[(size_t)s * width];
+                        if (xt.taps == 2) hresizeRow<2>(src.ptr<uchar>(sy[k]), out, xt, dstW, cn);
+                        else if (xt.taps == 4) hresizeRow<4>(src.ptr<uchar>(sy[k]), out, xt, dstW, cn);
+                        else hresizeRow<0>(src.ptr<uchar>(sy[k]), out, xt, dstW, cn);
+                        rows[k] = out;
+                        // later taps may read the same source row (clamped borders)
+                        for (int j = k + 1; j < taps; ++j)
+                            if (!rows[j] && sy[j] == sy[k]) rows[j] = out;
+                    }
+
+                    const int* w = &yt.weight[y * taps];
+                    uchar* d = dst.ptr<uchar>(y);
+                    if (taps == 2) vresizeLinear(rows[0], rows[1], w[0], w[1], d, width);
+                    else vresizeTaps(rows.data(), w, taps, d, width);
+                    if (minMax)
+                        rowMinMax(d, width, localMin, localMax);
+                }
+                if (minMax) {
+#pragma omp critical(vision_resize_minmax)
+                    {
+                        minMax[0] = std::min(minMax[0], localMin);
+                        minMax[1] = std::max(minMax[1], localMax);
+                    }
+                }
+            }
+        }
+
+        // ------------------------------------------------------------------
+        // Integer-ratio area decimation (2x/4x/8x): exact K x K box means.
+        // Column sums of K rows go to a 16-bit buffer (each at most 8 * 255), then
+        // K neighbouring sums per channel are added (the K x K total is at most
+        // 64 * 255, still within 16 bits) and rounded with a shift.
+        // ------------------------------------------------------------------
+        static void accumulateRow(const uchar* src, uint16_t* acc, int width, bool first) {
+            int x = 0;
+#if defined(VISION_SIMD_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for (; x <= width - 16; x += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+                __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+                if (!first) {
+                    lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i*)(acc + x)));
+                    hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i*)(acc + x + 8)));
+                }
+                _mm_storeu_si128((__m128i*)(acc + x), lo);
+                _mm_storeu_si128((__m128i*)(acc + x + 8), hi);
+            }
+#endif
+            for (; x < width; ++x)
+                acc[x] = static_cast<uint16_t>(first ? src[x] : acc[x] + src[x]);
+        }
+
+        template<int K, int CN>
+        static void decimateRow(const uint16_t* acc, uchar* dst, int dstW, int cn) {
+            const int ch = CN ? CN : cn;
+            const int shift = (K == 2) ? 2 : (K == 4) ? 4 : 6;
+            const int delta = 1 << (shift - 1);
+            int x = 0;
+#if defined(VISION_SIMD_SSE2)
+            if (K == 2 && CN == 1) {
+                // pairwise sums of 16-bit column sums
+                const __m128i ones = _mm_set1_epi16(1);
+                const __m128i d128 = _mm_set1_epi32(delta);
+                for (; x <= dstW - 8; x += 8) {
+                    __m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(acc + 2 * x)), ones);
+                    __m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(acc + 2 * x + 8)), ones);
+                    a = _mm_srai_epi32(_mm_add_epi32(a, d128), shift);
+                    b = _mm_srai_epi32(_mm_add_epi32(b, d128), shift);
+                    __m128i p = _mm_packs_epi32(a, b);
+                    _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(p, p));
+                }
+            }
+#endif
+            for (; x < dstW; ++x) {
+                const uint16_t* a = acc + x * K * ch;
+                for (int c = 0; c < ch; ++c) {
+                    int sum = 0;
+                    for (int j = 0; j < K; ++j) sum += a[j * ch + c];
+                    dst[x * ch + c] = static_cast<uchar>((sum + delta) >> shift);
+                }
+            }
+        }
+
+        template<int K>
+        static void decimate(const cv::Mat& src, cv::Mat& dst) {
+            const int cn = src.channels();
+            const int srcWidth = src.cols * cn;
+            const int dstW = dst.cols;
+#pragma omp parallel
+            {
+                std::vector<uint16_t> acc(srcWidth);
+#pragma omp for schedule(static)
+                for (int y = 0; y < dst.rows; ++y) {
+                    for (int r = 0; r < K; ++r)
+                        accumulateRow(src.ptr<uchar>(y * K + r), acc.data(), srcWidth, r == 0);
+                    uchar* d = dst.ptr<uchar>(y);
+                    if (cn == 1) decimateRow<K, 1>(acc.data(), d, dstW, cn);
+                    else if (cn == 3) decimateRow<K, 3>(acc.data(), d, dstW, cn);
+                    else decimateRow<K, 0>(acc.data(), d, dstW, cn);
+                }
+            }
+        }
+
+        // Returns true when the resize is an exact 2x, 4x or 8x decimation and was handled
+        static bool tryDecimate(const cv::Mat& src, cv::Mat& dst) {
+            for (int k : { 2, 4, 8 }) {
+                if (src.cols != dst.cols * k || src.rows != dst.rows * k)
+                    continue;
+                if (k == 2) decimate<2>(src, dst);
+                else if (k == 4) decimate<4>(src, dst);
+                else decimate<8>(src, dst);
+                return true;
+            }
+            return false;
+        }
+
         void resize(const cv::Mat& src,
             cv::Mat& dst,
             cv::Size dsize,
@@ -22,6 +475,7 @@ namespace vision {
             int interpolation)
         {
             CV_Assert(!src.empty());
+            CV_Assert(src.depth() == CV_8U);
 
             // Compute scale factors
             if (dsize.width == 0 && dsize.height == 0) {
@@ -35,110 +489,69 @@ namespace vision {
 
             CV_Assert(fx > 0 && fy > 0);
 
+            // dst may alias src (resize(img, img, ...)), keep the source alive
+            cv::Mat source = src;
+            if (source.data == dst.data)
+                source = src.clone();
             dst.create(dsize, src.type());
-            int channels = src.channels();
-
-            for (int y = 0; y < dsize.height; y++) {
-                double sy = (y + 0.5) / fy - 0.5;  // Map dst -> src
-                int y0 = std::floor(sy);
-                int y1 = std::min(y0 + 1, src.rows - 1);
-                sy -= y0;
-                if (y0 < 0) { y0 = 0; sy = 0; }
-
-                for (int x = 0; x < dsize.width; x++) {
-                    double sx = (x + 0.5) / fx - 0.5;
-                    int x0 = std::floor(sx);
-                    int x1 = std::min(x0 + 1, src.cols - 1);
-                    sx -= x0;
-                    if (x0 < 0) { x0 = 0; sx = 0; }
-
-                    if (interpolation == INTER_NEAREST) {
-                        int nearestY = clamp(int(std::round((y + 0.5) / fy - 0.5)), 0, src.rows - 1);
-                        int nearestX = clamp(int(std::round((x + 0.5) / fx - 0.5)), 0, src.cols - 1);
-
-                        if (channels == 1) {
-                            dst.at<uchar>(y, x) = src.at<uchar>(nearestY, nearestX);
-                        }
-                        else if (channels == 3) {
-                            dst.at<cv::Vec3b>(y, x) = src.at<cv::Vec3b>(nearestY, nearestX);
-                        }
-                    }
-                    else if (interpolation == INTER_LINEAR) {
-                        if (channels == 1) {
-                            double v00 = src.at<uchar>(y0, x0);
-                            double v01 = src.at<uchar>(y0, x1);
-                            double v10 = src.at<uchar>(y1, x0);
-                            double v11 = src.at<uchar>(y1, x1);
-
-                            double val0 = v00 * (1 - sx) + v01 * sx;
-                            double val1 = v10 * (1 - sx) + v11 * sx;
-                            double val = val0 * (1 - sy) + val1 * sy;
-
-                            dst.at<uchar>(y, x) = cv::saturate_cast<uchar>(val);
-                        }
-                        else if (channels == 3) {
-                            for (int c = 0; c < 3; c++) {
-                                double v00 = src.at<cv::Vec3b>(y0, x0)[c];
-                                double v01 = src.at<cv::Vec3b>(y0, x1)[c];
-                                double v10 = src.at<cv::Vec3b>(y1, x0)[c];
-                                double v11 = src.at<cv::Vec3b>(y1, x1)[c];
-
-                                double val0 = v00 * (1 - sx) + v01 * sx;
-                                double val1 = v10 * (1 - sx) + v11 * sx;
-                                double val = val0 * (1 - sy) + val1 * sy;
-
-                                dst.at<cv::Vec3b>(y, x)[c] = cv::saturate_cast<uchar>(val);
-                            }
-                        }
-                    }
-                    else if (interpolation == INTER_AREA) {
-                        // Weighted average of the pixels in the source area
-                        if (channels == 1) {
-                            double sum = 0.0;
-                            int count = 0;
-                            for (int yy = y0; yy < y1; yy++) {
-                                for (int xx = x0; xx < x1; xx++) {
-                                    sum += src.at<uchar>(yy, xx);
-                                    count++;
-                                }
-                            }
-                            dst.at<uchar>(y, x) = cv::saturate_cast<uchar>(sum / count);
-                        }
-                        else if (channels == 3) {
-                            double sum[3] = { 0,0,0 };
-                            int count = 0;
-                            for (int yy = y0; yy < y1; yy++) {
-                                for (int xx = x0; xx < x1; xx++) {
-                                    for (int c = 0; c < 3; c++) sum[c] += src.at<cv::Vec3b>(yy, xx)[c];
-                                    count++;
-                                }
-                            }
-                            for (int c = 0; c < 3; c++) dst.at<cv::Vec3b>(y, x)[c] = cv::saturate_cast<uchar>(sum[c] / count);
-                        }
-                    }
-                    else if (interpolation == INTER_CUBIC) {
-                        // Bicubic 4x4 neighborhood
-                        for (int c = 0; c < channels; c++) {
-                            double val = 0.0;
-                            for (int m = -1; m <= 2; m++) {
-                                int ym = clamp(y0 + m, 0, src.rows - 1);
-                                double wy = cubicWeight(m - sy);
-                                for (int n = -1; n <= 2; n++) {
-                                    int xn = clamp(x0 + n, 0, src.cols - 1);
-                                    double wx = cubicWeight(n - sx);
-                                    if (channels == 1)
-                                        val += src.at<uchar>(ym, xn) * wx * wy;
-                                    else
-                                        val += src.at<cv::Vec3b>(ym, xn)[c] * wx * wy;
-                                }
-                            }
-                            if (channels == 1)
-                                dst.at<uchar>(y, x) = cv::saturate_cast<uchar>(val);
-                            else
-                                dst.at<cv::Vec3b>(y, x)[c] = cv::saturate_cast<uchar>(val);
-                        }
-                    }
-                }
+            const int cn = src.channels();
+
+            AxisTable xt, yt;
+            if (interpolation == INTER_AREA) {
+                if (tryDecimate(source, dst))
+                    return;
+                buildArea(dsize.width, src.cols, fx, cn, xt);
+                buildArea(dsize.height, src.rows, fy, 1, yt);
+                resizeSeparable(source, dst, xt, yt);
+            }
+            else if (interpolation == INTER_NEAREST) {
+                buildNearest(dsize.width, src.cols, fx, cn, xt);
+                buildNearest(dsize.height, src.rows, fy, 1, yt);
+                resizeNearest(source, dst, xt, yt);
+            }
+            else if (interpolation == INTER_CUBIC) {
+                buildCubic(dsize.width, src.cols, fx, cn, xt);
+                buildCubic(dsize.height, src.rows, fy, 1, yt);
+                resizeSeparable(source, dst, xt, yt);
+            }
+            else {
+                buildLinear(dsize.width, src.cols, fx, cn, xt);
+                buildLinear(dsize.height, src.rows, fy, 1, yt);
+                resizeSeparable(source, dst, xt, yt);
+            }
+        }
+
+        void resizeNormalize(const cv::Mat& src, cv::Mat& dst, double fx, double fy) {
+            CV_Assert(src.type() == CV_8UC1);
+            CV_Assert(fx > 0 && fy > 0);
+            cv::Size dsize(cvRound(src.cols * fx), cvRound(src.rows * fy));
+
+            cv::Mat source = src;
+            if (source.data == dst.data)
+                source = src.clone();
+            dst.create(dsize, CV_8UC1);
+
+            AxisTable xt, yt;
+            buildLinear(dsize.width, src.cols, fx, 1, xt);
+            buildLinear(dsize.height, src.rows, fy, 1, yt);
+            int minMax[2];
+            resizeSeparable(source, dst, xt, yt, minMax);
+
+            // Same mapping as cv::normalize(..., 0, 255, NORM_MINMAX, CV_8U): a flat image maps to 0
+            const int vmin = minMax[0], vmax = minMax[1];
+            if (vmin == 0 && vmax == 255)
+                return;
+            const double scale = vmax > vmin ? 255.0 / (vmax - vmin) : 0.0;
+            const double shift = -vmin * scale;
+            uchar lut[256];
+            for (int v = 0; v < 256; ++v)
+                lut[v] = cv::saturate_cast<uchar>(v * scale + shift);
+
+#pragma omp parallel for schedule(static)
+            for (int y = 0; y < dst.rows; ++y) {
+                uchar* d = dst.ptr<uchar>(y);
+                for (int x = 0; x < dst.cols; ++x)
+                    d[x] = lut[d[x]];
             }
         }
 
@@ -219,9 +219,18 @@ bool PuReST::greedySearch(const cv::Mat& greedyDetectorEdges, const Pupil& baseP
 	cvtColor(input, dbgGreedy, CV_GRAY2BGR);
 #endif
 
-	vector<Vec4i> hierarchy;
 	vector<vector<Point> > curves;
-	findContours(greedyDetectorEdges, curves, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
+	if (linkEdges) {
+		// Same edge map filterEdges produced, so edgePixels lists it
+		edgeLinker.link(greedyDetectorEdges, edgePixels, vision::edge::LinkPoints::All);
+		curves.reserve(edgeLinker.count());
+		for (size_t i = 0; i < edgeLinker.count(); i++)
+			curves.push_back(edgeLinker.segment(i));
+	}
+	else {
+		vector<Vec4i> hierarchy;
+		findContours(greedyDetectorEdges, curves, hierarchy, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
+	}
 	for (auto c = curves.begin(); c != curves.end();) {
 		if (c->size() < 5)
 			c = curves.erase(c);
@@ -243,7 +252,8 @@ bool PuReST::greedySearch(const cv::Mat& greedyDetectorEdges, const Pupil& baseP
 		}
 	}
 
-	removeDuplicates(curves, greedyDetectorEdges.cols);
+	if (!linkEdges)
+		removeDuplicates(curves, greedyDetectorEdges.cols);
 
 	vector<GreedyCandidate> candidates;
 	for (int i = 0; i < curves.size(); i++) {
@@ -388,13 +398,7 @@ void PuReST::run(const cv::Mat& frame, const cv::Rect& roi, const Pupil& previou
 	 */
 	resize(frame(trackingRect), input, Size(), localScalingRatio, localScalingRatio, cv::INTER_LINEAR);
 
-	// Setup for Canny
 	workingSize = { input.cols, input.rows };
-	dx = Mat::zeros(workingSize.height, workingSize.width, CV_32F);
-	dy = Mat::zeros(workingSize.height, workingSize.width, CV_32F);
-	magnitude = Mat::zeros(workingSize.height, workingSize.width, CV_32F);
-	edgeType = Mat::zeros(workingSize.height, workingSize.width, CV_8U);
-	edge = Mat::zeros(workingSize.height, workingSize.width, CV_8U);
 
 	// Pupil in our coordinate system
 	Pupil basePupil = previousPupil;
@@ -43,6 +43,7 @@
 
 #include "TrackerMethod.h"
 #include "Pure.h"
+#include "Geometry.h"
 
 class GreedyCandidate
 {
@@ -52,16 +53,10 @@ public:
 		points(points)
 	{
 		cv::convexHull(points, hull);
-		maxGap = 0;
+		maxGap = vision::geometry::diameter(hull);
 		meanPoint = { 0, 0 };
-		for (auto p1 = hull.begin(); p1 != hull.end(); p1++) {
+		for (auto p1 = hull.begin(); p1 != hull.end(); p1++)
 			meanPoint += cv::Point2f(*p1);
-			for (auto p2 = p1 + 1; p2 != hull.end(); p2++) {
-				float gap = norm(*p2 - *p1);
-				if (gap > maxGap)
-					maxGap = gap;
-			}
-		}
 		meanPoint.x /= points.size();
 		meanPoint.y /= points.size();
 	}